@@ -1,841 +1,8929 @@
-#include "splashkit.h"
-#include <vector>
-using namespace std;
-
-//                                      ●▬▬▬▬   »»»       𝗽𝗹𝗮𝘆𝗲𝗿.𝗵       «««  ▬▬▬▬▬●
-
-#define MAX_VEL 3
-#define MAX_SPAWN 1000
-#define MIN_SPAWN -1000
-#define MAX_SPAWN_RANGE 2000
-
-/**
- * enum for the different parts of player 
- * the main ship and the force field
- */
-enum player_upgrade
-{
-    SHIELDED,
-    PLAYER
-};
-
-/**
- * The player data keeps track of all of the information related to the player.
- * 
- * @field   player_sprite   The player's sprite - used to track position and movement
- * @field   score           The current score for the player
- * @field   upgrade         current upgrade on player ship
- * @field   fuel_pct        the prcentage of fuel in player ship
- * @field   shield          checks if player has shield or not
- * @field   game_over       checks if the player lost or not
- */
-struct player_data
-{
-    sprite player_sprite;
-    int score;
-    player_upgrade upgrade;
-    double fuel_pct;
-    bool shield;
-    bool game_over;
-};
-
-/**
- * Creates a new player in the centre of the screen with the default ship.
- * 
- * @returns     The new player data
- */
-player_data new_player();
-
-/**
- * Draws the player to the screen. 
- * 
- * @param player_to_draw    The player to draw to the screen
- */
-void draw_player(const player_data &player_to_draw);
-
-/**
- * Actions a step update of the player - moving them and adjusting the camera.
- * 
- * @param player_to_update      The player being updated
- */
-void update_player(player_data &player_to_update);
-
-/**
- * Read user input and update the player based on this interaction.
- * 
- * @param player    The player to update
- */
-void handle_input(player_data &player);
-
-//                                      ●▬▬▬▬   »»»       𝗽𝗹𝗮𝘆𝗲𝗿.cpp       «««  ▬▬▬▬▬●
-
-player_data new_player()
-{
-    player_data result;
-    result.player_sprite = create_sprite(bitmap_named("player"));
-
-    /**
-     * @brief this code is used to add the force field bitmap as 
-     * a layer onto the player and to hide it till he picks
-     * up the shield power up
-     * 
-     */
-    vector_2d force_loc; // offsets the bitmap of force field so it fits perfectly on the player
-    force_loc.x = -25;
-    force_loc.y = -35;
-
-    sprite_add_layer(result.player_sprite, bitmap_named("force_field"), "force_field");
-    sprite_set_layer_offset(result.player_sprite, 1, force_loc);
-    sprite_hide_layer(result.player_sprite, 1);
-
-    // Position in the centre of the initial screen
-    sprite_set_x(result.player_sprite, (screen_width() - sprite_width(result.player_sprite)) / 2);
-    sprite_set_y(result.player_sprite, (screen_height() - sprite_height(result.player_sprite)) / 2);
-
-    return result;
-}
-
-void update_camera_position(double player_x, double player_y)
-{
-    // Test edge of screen boundaries to adjust the camera
-    // it is made so the edges are just the centre of the screen
-    // so the player remains in centre and world moves around him
-    double left_edge = camera_x() + screen_width() / 2;
-    double right_edge = left_edge + screen_width() - 2 * screen_width() / 2;
-    double top_edge = camera_y() + screen_height() / 2;
-    double bottom_edge = top_edge + screen_height() - 2 * screen_height() / 2;
-
-    // Test if the player is outside the area and move the camera
-    // the player will appear to stay still and everything else
-    // will appear to move :)
-
-    // Test top/bottom of screen
-    if (player_y < top_edge)
-    {
-        move_camera_by(0, player_y - top_edge);
-    }
-    else if (player_y > bottom_edge)
-    {
-        move_camera_by(0, player_y - bottom_edge);
-    }
-
-    // Test left/right of screen
-    if (player_x < left_edge)
-    {
-        move_camera_by(player_x - left_edge, 0);
-    }
-    else if (player_x > right_edge)
-    {
-        move_camera_by(player_x - right_edge, 0);
-    }
-}
-
-void draw_player(const player_data &player_to_draw)
-{
-    draw_sprite(player_to_draw.player_sprite);
-}
-
-void update_player(player_data &player_to_update)
-{
-    point_2d sprite_center = center_point(player_to_update.player_sprite);
-
-    update_sprite(player_to_update.player_sprite);
-
-    update_camera_position(sprite_center.x, sprite_center.y);
-}
-
-void handle_input(player_data &player)
-{
-    point_2d loc_play, loc_mouse, pos;
-
-    if (mouse_down(LEFT_BUTTON)) // code executed only if LMB is down
-    {
-        loc_play = center_point(player.player_sprite); // position of player's center
-        loc_mouse = mouse_position();                  // position of mouse
-
-        // makes the mouse position relative to player rather than the screen
-        pos.x = loc_play.x + loc_mouse.x - screen_width() / 2;
-        pos.y = loc_play.y + loc_mouse.y - screen_height() / 2;
-
-        // makes a vector out of the player and relative mouse position
-        // and also caps it with a limit.
-        vector_2d vel = vector_limit(vector_point_to_point(loc_play, pos), MAX_VEL);
-        sprite_set_velocity(player.player_sprite, vel);
-    }
-    else if (mouse_clicked(RIGHT_BUTTON)) // code executed only if RMB is clicked
-    {
-        // stops the player wherever it is
-        // by making velocity value 0
-        sprite_set_dx(player.player_sprite, 0);
-        sprite_set_dy(player.player_sprite, 0);
-    }
-}
-
-//                                      ●▬▬▬▬   »»»       entity.𝗵       «««  ▬▬▬▬▬●
-
-/**
- * Different options for the spawning entities.
- * Adjusts the image used.
- */
-enum entity_type
-{
-    SHIELD,
-    STAR,
-    FUEL,
-    ALLY_1,
-    ALLY_2,
-    ALLY_3,
-    ALLY_4,
-    FOE
-};
-
-/**
- * The player data keeps track of all of the information related to the spawn entities.
- * 
- * @field   entity_sprite     The entity sprite
- * @field   type             the type of entity
- */
-struct entity_data
-{
-    entity_type type;
-    sprite entity_sprite;
-};
-
-/**
- * Creates a new entity at a random location on the screen.
- * 
- * @param x a random point in x axes
- * @param y a random point in y axes
- */
-entity_data entity_spawn(double x, double y);
-
-/**
- * Draws the entity to the screen. 
- * 
- * @param entity_draw    The entity to draw to the screen
- */
-void draw_entity(const entity_data &entity_draw);
-
-/**
- * Actions an update of the entity - 
- * moving the entity in a random direction in a random speed.
- * 
- * @param entity_update      The entity being updated
- */
-void update_entity(entity_data &entity_update);
-
-//                                      ●▬▬▬▬   »»»       entity.cpp       «««  ▬▬▬▬▬●
-
-/**
- * The entity_bitmap function converts a entity type into a 
- * bitmap that can be used.
- * 
- * @param type  The type of entity
- * @return      The bitmap matching this entity type
- */
-bitmap entity_bitmap(entity_type type)
-{
-    switch (type)
-    {
-    case SHIELD:
-        return bitmap_named("shield");
-    case STAR:
-        return bitmap_named("star");
-    case ALLY_1:
-        return bitmap_named("ally_1");
-    case ALLY_2:
-        return bitmap_named("ally_2");
-    case ALLY_3:
-        return bitmap_named("ally_3");
-    case ALLY_4:
-        return bitmap_named("ally_4");
-    case FOE:
-        return bitmap_named("foe");
-    default:
-        return bitmap_named("fuel");
-    }
-}
-
-/**
- * The spawn_chance use rnd() function to choose 
- * the type of entity to spawn 
- * 
- * @return      the type of entity choosen through percentage chance
- */
-entity_type spawn_chance()
-{
-    // 30 percent chance that the spawned entity will be an ally
-    if (rnd() <= 0.3)
-        return static_cast<entity_type>(rnd(3, 7));
-
-    // 21 percent chance(out of 100) that the spawned entity is a foe
-    else if (rnd() <= 0.3)
-        return FOE;
-
-    // the rest chance is that spawned entity is a power up
-    else
-        return static_cast<entity_type>(rnd(3));
-}
-
-entity_data entity_spawn(double x, double y)
-{
-    entity_data result;
-    entity_type type = spawn_chance();
-    result.type = type;
-    result.entity_sprite = create_sprite(entity_bitmap(type));
-
-    // sets a random location of the entity on the screen
-    sprite_set_x(result.entity_sprite, x);
-    sprite_set_y(result.entity_sprite, y);
-
-    /**
-     * @brief 'if' statement checks if the spawn entity is not an ally
-     * 
-     * I have made my game such that the allies don't move and stay 
-     * at the location they spawn, so this 'if' block helps me with that.
-     * 
-     * entities other than allies go through the 'if' block
-     * and get random velocities.
-     */
-    if (type != ALLY_1 && type != ALLY_2 && type != ALLY_3 && type != ALLY_4)
-    {
-        // sets a random speed of the entity
-        sprite_set_dx(result.entity_sprite, rnd() * 4 - 2);
-        sprite_set_dy(result.entity_sprite, rnd() * 4 - 2);
-    }
-    return result;
-}
-
-void draw_entity(const entity_data &entity_draw)
-{
-    draw_sprite(entity_draw.entity_sprite);
-}
-
-void update_entity(entity_data &result)
-{
-    update_sprite(result.entity_sprite);
-}
-
-//                                      ●▬▬▬▬   »»»       space_wars.𝗵       «««  ▬▬▬▬▬●
-
-/**
- * The game_data keeps track of all of the information related to the game.
- * 
- * @field   player          player created for the game
- * @field   spawn           the vector which will contain the entities
- * @field   game_over_by    checks if player lost by getting hit or due to low fuel 
- */
-struct game_data
-{
-    player_data player;
-    vector<entity_data> spawner;
-    int game_over_by;
-};
-
-/**
- * Creates a new game with a new player on the screen.
- */
-game_data new_game();
-
-/**
- * Draws the game on the screen. 
- * 
- * @param game_draw    The game to draw to the screen
- */
-void draw_game(game_data &game_draw);
-
-/**
- * updates the game checking for changes in player
- * also checks the updates and spawning of power ups 
- * 
- * @param game_update      The game being updated
- */
-void update_game(game_data &game_update);
-
-//                                      ●▬▬▬▬   »»»       space_wars.cpp       «««  ▬▬▬▬▬●
-
-/**
- * @brief this function is a special one
- * it is used to give random sound to the allies
- * when they are rescued
- * 
- * till now there are 3 things the ally can say
- * - 'thank you' in japanese
- * - 'thank you' in spanish
- * - 'thank you' in hindi
- * ps: offcourse in their alien sounds
- * 
- * this function can be used to add more sounds in the future.
- */
-void random_noise()
-{
-    int num = rnd(3);
-    switch (num)
-    {
-    case 0:
-        play_sound_effect("thanks1");
-        break;
-    case 1:
-        play_sound_effect("thanks2");
-        break;
-    default:
-        play_sound_effect("thanks3");
-        break;
-    }
-}
-
-/**
- * this function is used to apply a specific power up
- * or see if player picked up ally
- * or if player decided to attack the foe without thinking
- * 
- * @param game  the main game variable used in various tasks
- * @param i     an integer used to know the index of power up in vector
- */
-void apply_spawn(game_data &game, int idx)
-{
-    // Increasing the value only if the percentage is less than 100
-    if (game.spawner[idx].type == FUEL)
-    {
-        play_sound_effect("fuel");
-
-        // fills in 25% of total capacity of fuel tank
-        if (game.player.fuel_pct < 0.75)
-            game.player.fuel_pct += 0.25;
-        else
-            game.player.fuel_pct += 1 - game.player.fuel_pct;
-    }
-    else if (game.spawner[idx].type == STAR)
-    {
-        play_sound_effect("star");
-        game.player.score += 30;
-    }
-    else if (game.spawner[idx].type == ALLY_1 or game.spawner[idx].type == ALLY_2)
-    {
-        random_noise();
-        game.player.score += 10;
-    }
-    else if (game.spawner[idx].type == ALLY_3 or game.spawner[idx].type == ALLY_4)
-    {
-        random_noise();
-        game.player.score += 10;
-    }
-    else if (game.spawner[idx].type == FOE)
-    {
-        if (game.player.shield == false)
-        {
-            game.player.game_over = true;
-            game.game_over_by = 1;
-
-            play_sound_effect("hit");
-        }
-        else
-        {
-            sprite_hide_layer(game.player.player_sprite, 1);
-            play_sound_effect("shield_hit");
-        }
-        game.player.shield = false;
-    }
-    else
-    {
-        sprite_show_layer(game.player.player_sprite, 1);
-        play_sound_effect("activated");
-
-        game.player.shield = true;
-    }
-}
-
-/**
- * this function is used to remove a specific power up
- * 
- * @param game  the main game variable used in various tasks
- * @param i     an integer used to know the index of power up in vector
- */
-void remove_spawn(game_data &game, int idx)
-{
-    int last;
-
-    if (idx >= 0 && idx < game.spawner.size())
-    {
-        last = game.spawner.size() - 1;
-        game.spawner[idx] = game.spawner[last];
-        game.spawner.pop_back();
-    }
-}
-
-/**
- * this function is used to remove (despawn) power up
- * if it goes out of 2000 pixel spawner radius of player.
- * 
- * @param game  the main game variable used in various tasks
- */
-void check_entity_position(game_data &game)
-{
-    point_2d location = center_point(game.player.player_sprite);
-
-    int x, y;
-    x = (int)location.x;
-    y = (int)location.y;
-
-    for (int i = 0; i < game.spawner.size(); i++)
-    {
-        double entity_x = sprite_x(game.spawner[i].entity_sprite);
-        double entity_y = sprite_y(game.spawner[i].entity_sprite);
-
-        // The entity is removed if it goes out of the 2000 pixels from player
-        if (entity_x > x + MAX_SPAWN or entity_y > y + MAX_SPAWN or entity_x < x + MIN_SPAWN or entity_y < y + MIN_SPAWN)
-        {
-            remove_spawn(game, i);
-        }
-    }
-}
-
-/**
- * this function is used to check collision of power up with player
- * 
- * @param game  the main game variable used in various tasks
- */
-void check_collision(game_data &game)
-{
-    for (int num = game.spawner.size() - 1; num >= 0; num--)
-    {
-        if (sprite_collision(game.player.player_sprite, game.spawner[num].entity_sprite))
-        {
-            apply_spawn(game, num);
-            remove_spawn(game, num);
-        }
-    }
-}
-
-/**
- * The entity_bitmap function converts a power up type into a 
- * bitmap that can be used.
- * 
- * @param game  the main game variable used in various tasks
- */
-void spawn_entity(game_data &game)
-{
-    point_2d location = center_point(game.player.player_sprite);
-
-    int x, y;
-
-    x = (int)location.x;
-    y = (int)location.y;
-
-    // spawns entities in spawning area of the player
-    game.spawner.push_back(entity_spawn(x + rnd(MIN_SPAWN, MAX_SPAWN), y + rnd(MIN_SPAWN, MAX_SPAWN)));
-}
-
-game_data new_game()
-{
-    game_data new_game;
-
-    new_game.player = new_player();
-    new_game.player.shield = false;
-    new_game.player.game_over = false;
-    new_game.player.fuel_pct = 1;
-    new_game.player.score = 0;
-    new_game.game_over_by = 1;
-
-    return new_game;
-}
-
-void draw_game(game_data &game_draw)
-{
-    draw_player(game_draw.player);
-
-    for (int num = 0; num < game_draw.spawner.size(); num++)
-    {
-        draw_entity(game_draw.spawner[num]);
-    }
-}
-
-void update_game(game_data &game_update)
-{
-    // limits the total entities on map to be 20
-    if (rnd() < 0.02 && game_update.spawner.size() < 20)
-        spawn_entity(game_update);
-
-    update_player(game_update.player);
-
-    check_collision(game_update);
-    check_entity_position(game_update);
-
-    for (int num = 0; num < game_update.spawner.size(); num++)
-    {
-        update_entity(game_update.spawner[num]);
-    }
-}
-
-//                                      ●▬▬▬▬   »»»       program.cpp       «««  ▬▬▬▬▬●
-
-/**
- * Load the game images, sounds, etc.
- * also text for hud.
- */
-void load_resources()
-{
-    load_resource_bundle("game_bundle", "space_wars.txt");
-}
-
-/**
- * this is used to simplify the location to integer values
- * for easier display on screen. 
- * 
- * @param player    the player whose location is checked
- * @return          string with location of player for hud
- */
-string loc_to_string(const player_data &player)
-{
-    point_2d location = center_point(player.player_sprite);
-    int x, y;
-    x = (int)location.x;
-    y = (int)location.y;
-    return to_string(x) + " " + to_string(y);
-}
-
-/**
- * this function is used to get the position of a specific entity
- * relative to the size of the screen dimensions.
- * 
- * @param game  the main game variable used in various tasks
- * @param i     an integer used to know the index of entity in vector
- * @return      the co-ordinates of certain entity relative to your screen size 
- */
-point_2d spawn_mini_map_coordinate(const game_data &game, int i)
-{
-    point_2d location = center_point(game.player.player_sprite);
-    int x, y;
-    x = (int)location.x;
-    y = (int)location.y;
-    double entity_x, entity_y, mini_map_x, mini_map_y;
-
-    entity_x = sprite_x(game.spawner[i].entity_sprite);
-    entity_y = sprite_y(game.spawner[i].entity_sprite);
-
-    // Calculating the coordinate of the entity according to the minimap
-    mini_map_x = (entity_x - x - MIN_SPAWN) / MAX_SPAWN_RANGE * 100 + 20;
-    mini_map_y = (entity_y - y - MIN_SPAWN) / MAX_SPAWN_RANGE * 100 + 20;
-
-    return point_at(mini_map_x, mini_map_y);
-}
-
-/**
- * this procedure is used to draw a mini map in the game
- * it also draws pixels for position of several entities and the player
- * 
- * @param game  The game details used for various tasks
- */
-void draw_minimap(const game_data &game)
-{
-    fill_rectangle(COLOR_BLACK, 20, 20, 100, 100, option_to_screen());
-    draw_rectangle(COLOR_WHITE, 20, 20, 100, 100, option_to_screen());
-
-    for (int i = 0; i < game.spawner.size(); i++)
-    {
-        if (game.spawner[i].type == FOE)
-            // Drawing position of the foe with red colour
-            draw_pixel(rgba_color(255, 0, 0, 240), spawn_mini_map_coordinate(game, i), option_to_screen());
-
-        else if (game.spawner[i].type == SHIELD or game.spawner[i].type == STAR or game.spawner[i].type == FUEL)
-            // Drawing position of the power ups with green colour
-            draw_pixel(rgba_color(0, 255, 0, 240), spawn_mini_map_coordinate(game, i), option_to_screen());
-
-        else
-            // Drawing position of the allies with cyan colour
-            draw_pixel(rgba_color(0, 255, 255, 240), spawn_mini_map_coordinate(game, i), option_to_screen());
-    }
-
-    //Drawing position of the player with white colour
-    draw_pixel(rgba_color(255, 255, 255, 255), point_at(70, 70), option_to_screen());
-}
-
-/**
- * procedure to draw the force field sign
- * on the hud to indicate that shield is active
- * it depens on :-
- * shield in struct player_data
- */
-void shield_disp(const player_data &player_shield_display)
-{
-    if (player_shield_display.shield)
-    {
-        draw_bitmap("force", 65, 510, option_to_screen());
-    }
-}
-
-/**
- * this procedure to display fuel in the hud
- * the amount of fuel displayed depends on :-
- *  
- * fuel_pct in struct player_data
- */
-void fuel_checker(game_data &game_player_fuel)
-{
-    double part_width = game_player_fuel.player.fuel_pct * bitmap_width("full");
-
-    draw_text("FUEL: ", COLOR_BRIGHT_GREEN, "font", 25, 10, 555, option_to_screen());
-    draw_bitmap("empty", 70, 550, option_to_screen());
-    draw_bitmap("full", 70, 550, option_part_bmp(0, 0, part_width, bitmap_height("full"), option_to_screen()));
-
-    if (sprite_dx(game_player_fuel.player.player_sprite) != 0)
-        game_player_fuel.player.fuel_pct -= 0.00028;
-
-    if (game_player_fuel.player.fuel_pct <= 0)
-    {
-        game_player_fuel.game_over_by = 2;
-        game_player_fuel.player.game_over = true;
-    }
-}
-
-/**
- * procedure to display the hud
- * and all the features in it.
- */
-void display_hub(game_data &game)
-{
-    // score of the player
-    draw_text("SCORE: " + to_string(game.player.score), COLOR_WHITE, 1090, 590, option_to_screen());
-
-    // location of the player
-    draw_text("LOCATION: " + loc_to_string(game.player), COLOR_WHITE, screen_width() / 2 - 60, screen_height() - 15, option_to_screen());
-
-    // background of hud display
-    draw_bitmap("hud", 1, 490, option_to_screen());
-
-    fuel_checker(game);
-    shield_disp(game.player);
-    // star_disp(game.player);
-
-    draw_minimap(game);
-}
-
-/**
- * @brief   procedure to display the welcome screen
- *          with the rules and controls of game
- * 
- * @param choice    it decides what to display as per users choice
- */
-void welcome_screen(int &choice)
-{
-    choice = 1;
-
-    while (not quit_requested())
-    {
-        process_events();
-        clear_screen(COLOR_BLACK);
-
-        if (key_typed(BACKSPACE_KEY) or choice == 1)
-        {
-            choice = 1;
-            draw_bitmap("1", 0, 0, option_to_screen());
-        }
-
-        if (key_typed(NUM_1_KEY) or choice == 2)
-        {
-            choice = 2;
-            draw_bitmap("2", 0, 0, option_to_screen());
-        }
-
-        if (key_typed(SPACE_KEY))
-            break;
-
-        refresh_screen(60);
-    }
-}
-
-/**
- * @brief   procedure to display the end screen
- *          with the score of player
- * 
- * @param game      the main game variable used in various tasks
- * @param choice    displays end screen as per players loss
- */
-void end_screen(const game_data &game, int &choice)
-{
-    choice = game.game_over_by;
-
-    while (not quit_requested())
-    {
-        process_events();
-        clear_screen(COLOR_BLACK);
-
-        if (choice == 2)
-        {
-            draw_bitmap("end_fuel", 0, 0, option_to_screen());
-        }
-
-        else
-        {
-            draw_bitmap("end_hit", 0, 0, option_to_screen());
-        }
-
-        if (key_typed(SPACE_KEY))
-        {
-            choice = 1;
-            break;
-        }
-
-        if (key_typed(X_KEY))
-        {
-            choice = 0;
-            break;
-        }
-        draw_text("SCORE - " + to_string(game.player.score), COLOR_WHITE, "game_font", 35, 390, 350, option_to_screen());
-        refresh_screen(60);
-    }
-}
-
-/**
- * Entry point.
- * 
- * Manages the initialisation of data, the event loop, and quitting.
- */
-int main()
-{
-    open_window("space wars", 1200, 600);
-    load_resources();
-
-    int choice = 1;
-    while (not quit_requested())
-    {
-
-        game_data game = new_game();
-
-        welcome_screen(choice);
-
-        while (not quit_requested())
-        {
-            // checks and plays music if not playing
-            if (not music_playing())
-                play_music("bg");
-
-            // Handle input to adjust player movement
-            process_events();
-            handle_input(game.player); // Perform movement and update the camera
-
-            update_game(game);
-
-            // Redraw everything
-            clear_screen(COLOR_BLACK);
-
-            // draw game and hud
-            draw_game(game);
-            display_hub(game);
-
-            if (game.player.game_over)
-                break;
-
-            refresh_screen(60);
-        }
-
-        stop_music();
-
-        end_screen(game, choice);
-        if (choice == 0)
-            break;
-    }
-    return 0;
-}
-
+#include "splashkit.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+using namespace std;
+
+//                                      ●▬▬▬▬   »»»       resources.𝗵       «««  ▬▬▬▬▬●
+
+/**
+ * Counts the resources the game has made and not freed yet. Everywhere that
+ * creates or frees a sprite, bitmap, sound or timer event keeps these up to
+ * date, so a leak shows up as a count that keeps on growing.
+ * 
+ * @field   sprites     live sprites
+ * @field   bitmaps     live bitmaps, loaded or created
+ * @field   sounds      loaded sound effects and music
+ * @field   timers      timer events waiting to fire
+ */
+struct resource_ledger
+{
+    atomic<long> sprites;
+    atomic<long> bitmaps;
+    atomic<long> sounds;
+    atomic<long> timers;
+};
+
+// the one ledger for the whole program
+resource_ledger live_resources;
+
+/**
+ * A copy of the ledger at one moment, with the memory in use then.
+ * 
+ * @field   rss_kb      resident memory of the process in kilobytes
+ */
+struct resource_counts
+{
+    long sprites;
+    long bitmaps;
+    long sounds;
+    long timers;
+    long rss_kb;
+};
+
+/**
+ * @return  the ledger counts and memory use right now
+ */
+resource_counts current_resources();
+
+/**
+ * Adds (or takes away when freeing) the bitmaps and sounds a resource
+ * bundle loads to the ledger.
+ * 
+ * @param file      the bundle file
+ * @param change    1 when loading the bundle, -1 when freeing it
+ */
+void count_bundle_resources(const string &file, int change);
+
+//                                      ●▬▬▬▬   »»»       resources.cpp       «««  ▬▬▬▬▬●
+
+/**
+ * reads the resident memory of the process, 0 where it is not known
+ */
+long resident_memory_kb()
+{
+#if defined(__linux__)
+    // statm holds the total and resident size in pages
+    ifstream statm("/proc/self/statm");
+    long total = 0, resident = 0;
+
+    if (statm >> total >> resident)
+        return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#endif
+    return 0;
+}
+
+resource_counts current_resources()
+{
+    resource_counts result;
+    result.sprites = live_resources.sprites;
+    result.bitmaps = live_resources.bitmaps;
+    result.sounds = live_resources.sounds;
+    result.timers = live_resources.timers;
+    result.rss_kb = resident_memory_kb();
+    return result;
+}
+
+void count_bundle_resources(const string &file, int change)
+{
+    ifstream bundle(path_to_resource(file, BUNDLE_RESOURCE));
+    string line;
+
+    while (getline(bundle, line))
+    {
+        string kind = line.substr(0, line.find(','));
+
+        if (kind == "BITMAP")
+            live_resources.bitmaps += change;
+        else if (kind == "SOUND" or kind == "MUSIC")
+            live_resources.sounds += change;
+    }
+}
+
+//                                      ●▬▬▬▬   »»»       random.𝗵       «««  ▬▬▬▬▬●
+
+/**
+ * A random number generator owned by one game, so games can run side by
+ * side and a game started with the same seed plays out the same way.
+ * SplashKit's rnd() is shared by the whole program.
+ * 
+ * @field   state   the generator state, never 0
+ */
+struct game_rng
+{
+    uint64_t state;
+};
+
+/**
+ * Creates a generator from a seed, any seed (even 0) is fine.
+ */
+game_rng new_rng(uint64_t seed);
+
+/**
+ * @return  a random number from 0 up to (not including) 1, like rnd()
+ */
+float rng_float(game_rng &rng);
+
+/**
+ * @return  a random whole number from min up to (not including) max, like rnd(min, max)
+ */
+int rng_int(game_rng &rng, int min, int max);
+
+//                                      ●▬▬▬▬   »»»       random.cpp       «««  ▬▬▬▬▬●
+
+game_rng new_rng(uint64_t seed)
+{
+    // splitmix64 spreads nearby seeds far apart
+    uint64_t z = seed + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z = z ^ (z >> 31);
+
+    game_rng result;
+    result.state = z ? z : 1;
+    return result;
+}
+
+/**
+ * xorshift64*, fast and good enough for a game
+ */
+uint64_t rng_next(game_rng &rng)
+{
+    rng.state ^= rng.state >> 12;
+    rng.state ^= rng.state << 25;
+    rng.state ^= rng.state >> 27;
+    return rng.state * 0x2545f4914f6cdd1dULL;
+}
+
+float rng_float(game_rng &rng)
+{
+    // the top 24 bits fit a float exactly
+    return (rng_next(rng) >> 40) * (1.0f / 16777216.0f);
+}
+
+int rng_int(game_rng &rng, int min, int max)
+{
+    if (max <= min)
+        return min;
+    return min + (int)(rng_next(rng) % (uint64_t)((long long)max - min));
+}
+
+//                                      ●▬▬▬▬   »»»       pool.𝗵       «««  ▬▬▬▬▬●
+
+/**
+ * Threads started once and kept waiting for work, so work split over them
+ * many times a second does not pay for starting threads every time. The
+ * thread that hands out the work does its share too, so a pool of n threads
+ * keeps n - 1 of its own.
+ * 
+ * @field   workers     the pool's own threads
+ * @field   lock        guards the fields below up to stopping
+ * @field   wake        signalled when there is a new job or the pool stops
+ * @field   done        signalled when the last worker finished its part of the job
+ * @field   job         the job being run, called with the number of each task
+ * @field   tasks       number of tasks in the job
+ * @field   working     workers not done with the job yet
+ * @field   round       counts the jobs, so a waking worker can tell a new one
+ * @field   stopping    set when the pool is freed
+ * @field   next_task   the next task to be taken
+ * @field   busy        set while a job runs, a job started from inside one runs on its own thread
+ */
+struct worker_pool
+{
+    vector<thread> workers;
+    mutex lock;
+    condition_variable wake, done;
+    const function<void(size_t)> *job;
+    size_t tasks;
+    size_t working;
+    uint64_t round;
+    bool stopping;
+    atomic<size_t> next_task;
+    atomic<bool> busy;
+};
+
+/**
+ * Starts a pool.
+ * 
+ * @param threads   threads to run jobs on counting the caller, 0 for one per core
+ */
+worker_pool *new_worker_pool(int threads);
+
+/**
+ * @return  the threads a job can run on, counting the caller, 1 without a pool
+ */
+size_t pool_threads(const worker_pool *pool);
+
+/**
+ * Runs job(0) up to job(tasks - 1) over the pool and the calling thread, and
+ * returns once they are all done. Without a pool, or when the pool is
+ * already running a job, the tasks run one after the other on the caller.
+ * 
+ * @param pool      the pool, can be nullptr
+ * @param tasks     number of tasks
+ * @param job       the work of one task
+ */
+void run_on_pool(worker_pool *pool, size_t tasks, const function<void(size_t)> &job);
+
+/**
+ * Stops the pool's threads and frees it.
+ */
+void free_worker_pool(worker_pool *pool);
+
+//                                      ●▬▬▬▬   »»»       pool.cpp       «««  ▬▬▬▬▬●
+
+/**
+ * takes tasks of the current job until there are none left
+ */
+void run_pool_tasks(worker_pool &pool)
+{
+    for (size_t task = pool.next_task++; task < pool.tasks; task = pool.next_task++)
+    {
+        (*pool.job)(task);
+    }
+}
+
+/**
+ * what each of the pool's threads does until the pool is freed
+ */
+void pool_worker(worker_pool &pool)
+{
+    uint64_t seen = 0;
+
+    while (true)
+    {
+        unique_lock<mutex> guard(pool.lock);
+        pool.wake.wait(guard, [&]() { return pool.stopping or pool.round != seen; });
+        if (pool.stopping)
+            return;
+        seen = pool.round;
+        guard.unlock();
+
+        run_pool_tasks(pool);
+
+        guard.lock();
+        if (--pool.working == 0)
+            pool.done.notify_one();
+    }
+}
+
+worker_pool *new_worker_pool(int threads)
+{
+    worker_pool *result = new worker_pool;
+    result->job = nullptr;
+    result->tasks = 0;
+    result->working = 0;
+    result->round = 0;
+    result->stopping = false;
+    result->next_task = 0;
+    result->busy = false;
+
+    int count = threads > 0 ? threads : max(1u, thread::hardware_concurrency());
+    for (int t = 1; t < count; t++)
+    {
+        result->workers.emplace_back(pool_worker, ref(*result));
+    }
+    return result;
+}
+
+size_t pool_threads(const worker_pool *pool)
+{
+    return pool ? pool->workers.size() + 1 : 1;
+}
+
+void run_on_pool(worker_pool *pool, size_t tasks, const function<void(size_t)> &job)
+{
+    bool idle = false;
+    if (not pool or pool->workers.empty() or tasks <= 1 or not pool->busy.compare_exchange_strong(idle, true))
+    {
+        for (size_t task = 0; task < tasks; task++)
+        {
+            job(task);
+        }
+        return;
+    }
+
+    {
+        lock_guard<mutex> guard(pool->lock);
+        pool->job = &job;
+        pool->tasks = tasks;
+        pool->next_task = 0;
+        pool->working = pool->workers.size();
+        pool->round++;
+    }
+    pool->wake.notify_all();
+
+    run_pool_tasks(*pool);
+
+    // every worker has to be done with the job before the next one can start
+    unique_lock<mutex> guard(pool->lock);
+    pool->done.wait(guard, [&]() { return pool->working == 0; });
+    pool->busy = false;
+}
+
+void free_worker_pool(worker_pool *pool)
+{
+    {
+        lock_guard<mutex> guard(pool->lock);
+        pool->stopping = true;
+    }
+    pool->wake.notify_all();
+
+    for (size_t t = 0; t < pool->workers.size(); t++)
+    {
+        pool->workers[t].join();
+    }
+    delete pool;
+}
+
+//                                      ●▬▬▬▬   »»»       render.𝗵       «««  ▬▬▬▬▬●
+
+#define RENDER_PARALLEL_MIN 20000
+#define RENDER_BENCH_FRAMES 120
+
+/**
+ * The layers of a frame, drawn from the first to the last. Inside a layer
+ * the commands are grouped by what they draw with, so anything that has to
+ * be drawn over something else in the same place needs a later layer.
+ * Only draws with the same key, the same kind of shape or the same bitmap,
+ * keep the order they were recorded in. The ships and projectiles crossing
+ * each other are the one overlap left to the sort, any of them can be on top.
+ */
+enum render_layer
+{
+    LAYER_PLANETS,
+    LAYER_PLAYER,
+    LAYER_SHIELD,
+    LAYER_SHIPS,
+    LAYER_PROJECTILES,
+    LAYER_EFFECTS,
+    LAYER_HUD_BACK,
+    LAYER_HUD_GAUGE,
+    LAYER_HUD,
+    LAYER_HUD_FRONT
+};
+
+/**
+ * What a render command draws, one for each splashkit call it ends up as.
+ */
+enum render_kind
+{
+    RENDER_BITMAP,
+    RENDER_FILL_RECTANGLE,
+    RENDER_RECTANGLE,
+    RENDER_PIXEL,
+    RENDER_TRIANGLE,
+    RENDER_TEXT
+};
+
+/**
+ * One thing to draw on the screen. The key puts the layer first, then the
+ * kind, the blending and the bitmap, so sorting by it keeps the layers in
+ * order and puts the draws that share a bitmap next to each other, where
+ * a renderer that batches could send them to the graphics card together.
+ * 
+ * @field   key             layer, kind, blending and bitmap, highest bits first
+ * @field   kind            the splashkit call
+ * @field   image           the bitmap drawn, empty for shapes and text
+ * @field   tint            colour of a shape or text
+ * @field   x, y            top left on the screen, or the first corner of a triangle
+ * @field   width, height   size of a rectangle, or the part of the bitmap drawn (0 for all of it)
+ * @field   scale           size a bitmap is drawn at, around its centre
+ * @field   x2, y2, x3, y3  the other corners of a triangle
+ * @field   text            the text drawn, in the list's texts
+ */
+struct render_command
+{
+    uint32_t key;
+    render_kind kind;
+    bitmap image;
+    color tint;
+    float x, y;
+    float width, height;
+    float scale;
+    float x2, y2, x3, y3;
+    int text;
+};
+
+/**
+ * A text command's words and font, kept out of the commands so they stay small.
+ * 
+ * @field   words   the text
+ * @field   font    name of the font, empty for splashkit's own
+ * @field   size    size of the font
+ */
+struct render_text
+{
+    string words;
+    string font;
+    int size;
+};
+
+/**
+ * The commands of a frame, in the order the game recorded them. A list is
+ * only ever filled by one thread, but a worker thread can fill its own and
+ * have it added to the frame's after.
+ * 
+ * @field   commands    the recorded commands
+ * @field   texts       the words of the text commands
+ * @field   order       the commands sorted by key, as key << 32 | index
+ * @field   scratch     reused by the radix sort
+ */
+struct render_list
+{
+    vector<render_command> commands;
+    vector<render_text> texts;
+    vector<uint64_t> order;
+    vector<uint64_t> scratch;
+};
+
+/**
+ * Empties a list for the next frame, keeping its memory.
+ */
+void clear_render_list(render_list &list);
+
+/**
+ * Records a bitmap drawn with its top left at (x, y) on the screen, scaled
+ * around its centre like splashkit does.
+ */
+void record_bitmap(render_list &list, render_layer layer, bitmap image, float x, float y, float scale);
+
+/**
+ * Records the part of a bitmap from its top left that is width by height big.
+ */
+void record_bitmap_part(render_list &list, render_layer layer, bitmap image, float x, float y, float width, float height);
+
+/**
+ * Records a filled rectangle.
+ */
+void record_fill_rectangle(render_list &list, render_layer layer, const color &tint, float x, float y, float width, float height);
+
+/**
+ * Records the outline of a rectangle.
+ */
+void record_rectangle(render_list &list, render_layer layer, const color &tint, float x, float y, float width, float height);
+
+/**
+ * Records a single pixel.
+ */
+void record_pixel(render_list &list, render_layer layer, const color &tint, float x, float y);
+
+/**
+ * Records a filled triangle.
+ */
+void record_fill_triangle(render_list &list, render_layer layer, const color &tint, float x1, float y1, float x2, float y2, float x3, float y3);
+
+/**
+ * Records a text, in splashkit's own font when the font is empty.
+ */
+void record_text(render_list &list, render_layer layer, const string &words, const color &tint, const string &font, int size, float x, float y);
+
+/**
+ * Adds the commands of one list after the commands of another.
+ * 
+ * @param list  the list added to
+ * @param other the list added, left as it is
+ */
+void append_render_list(render_list &list, const render_list &other);
+
+/**
+ * Sorts the commands by key with a radix sort. Commands with the same key
+ * keep the order they were recorded in.
+ */
+void sort_render_list(render_list &list);
+
+/**
+ * Counts the runs of commands next to each other that draw with the same
+ * bitmap, or the same kind of shape and blending, with every text a run of
+ * its own. These are the draws a batching renderer could merge, not the
+ * calls that are made: submit_render_list still makes one call per command.
+ * 
+ * @param list      the list
+ * @param sorted    count in the sorted order, otherwise in the order recorded
+ */
+size_t count_render_runs(const render_list &list, bool sorted);
+
+/**
+ * Sorts the list and draws every command on the screen.
+ * 
+ * @return  the number of splashkit draw calls made
+ */
+size_t submit_render_list(render_list &list);
+
+//                                      ●▬▬▬▬   »»»       render.cpp       «««  ▬▬▬▬▬●
+
+void clear_render_list(render_list &list)
+{
+    list.commands.clear();
+    list.texts.clear();
+}
+
+/**
+ * the key of a command. bitmaps are told apart by a hash of their address,
+ * so lists filled on different threads agree without sharing anything. two
+ * bitmaps with the same hash only end up in the same group
+ */
+uint32_t render_key(render_layer layer, render_kind kind, bool blended, bitmap image)
+{
+    uint32_t texture = (uint32_t)(((uint64_t)(uintptr_t)image * 0x9e3779b97f4a7c15ULL) >> 48);
+    return (uint32_t)layer << 28 | (uint32_t)kind << 25 | (uint32_t)blended << 24 | texture << 8;
+}
+
+/**
+ * adds a command with everything but its kind, layer and bitmap set to nothing
+ */
+render_command &new_render_command(render_list &list, render_layer layer, render_kind kind, const color &tint, bitmap image)
+{
+    // bitmaps always blend their edges, shapes only when see through
+    bool blended = image or tint.a < 1;
+
+    render_command command;
+    command.key = render_key(layer, kind, blended, image);
+    command.kind = kind;
+    command.image = image;
+    command.tint = tint;
+    command.x = command.y = 0;
+    command.width = command.height = 0;
+    command.scale = 1;
+    command.x2 = command.y2 = command.x3 = command.y3 = 0;
+    command.text = -1;
+
+    list.commands.push_back(command);
+    return list.commands.back();
+}
+
+void record_bitmap(render_list &list, render_layer layer, bitmap image, float x, float y, float scale)
+{
+    render_command &command = new_render_command(list, layer, RENDER_BITMAP, COLOR_WHITE, image);
+    command.x = x;
+    command.y = y;
+    command.scale = scale;
+}
+
+void record_bitmap_part(render_list &list, render_layer layer, bitmap image, float x, float y, float width, float height)
+{
+    render_command &command = new_render_command(list, layer, RENDER_BITMAP, COLOR_WHITE, image);
+    command.x = x;
+    command.y = y;
+    command.width = width;
+    command.height = height;
+}
+
+void record_fill_rectangle(render_list &list, render_layer layer, const color &tint, float x, float y, float width, float height)
+{
+    render_command &command = new_render_command(list, layer, RENDER_FILL_RECTANGLE, tint, nullptr);
+    command.x = x;
+    command.y = y;
+    command.width = width;
+    command.height = height;
+}
+
+void record_rectangle(render_list &list, render_layer layer, const color &tint, float x, float y, float width, float height)
+{
+    render_command &command = new_render_command(list, layer, RENDER_RECTANGLE, tint, nullptr);
+    command.x = x;
+    command.y = y;
+    command.width = width;
+    command.height = height;
+}
+
+void record_pixel(render_list &list, render_layer layer, const color &tint, float x, float y)
+{
+    render_command &command = new_render_command(list, layer, RENDER_PIXEL, tint, nullptr);
+    command.x = x;
+    command.y = y;
+}
+
+void record_fill_triangle(render_list &list, render_layer layer, const color &tint, float x1, float y1, float x2, float y2, float x3, float y3)
+{
+    render_command &command = new_render_command(list, layer, RENDER_TRIANGLE, tint, nullptr);
+    command.x = x1;
+    command.y = y1;
+    command.x2 = x2;
+    command.y2 = y2;
+    command.x3 = x3;
+    command.y3 = y3;
+}
+
+void record_text(render_list &list, render_layer layer, const string &words, const color &tint, const string &font, int size, float x, float y)
+{
+    render_command &command = new_render_command(list, layer, RENDER_TEXT, tint, nullptr);
+    command.x = x;
+    command.y = y;
+    command.text = list.texts.size();
+    list.texts.push_back({words, font, size});
+}
+
+void append_render_list(render_list &list, const render_list &other)
+{
+    size_t first = list.commands.size();
+    int text_offset = list.texts.size();
+
+    list.commands.insert(list.commands.end(), other.commands.begin(), other.commands.end());
+    list.texts.insert(list.texts.end(), other.texts.begin(), other.texts.end());
+
+    for (size_t i = first; i < list.commands.size(); i++)
+    {
+        if (list.commands[i].text >= 0)
+            list.commands[i].text += text_offset;
+    }
+}
+
+void sort_render_list(render_list &list)
+{
+    size_t count = list.commands.size();
+    list.order.resize(count);
+    list.scratch.resize(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        list.order[i] = (uint64_t)list.commands[i].key << 32 | i;
+    }
+
+    // the low byte of every key is 0, so three passes over the other bytes sort them all.
+    // each pass is stable, so equal keys stay in the order they were recorded
+    for (int shift = 40; shift < 64; shift += 8)
+    {
+        size_t starts[257] = {0};
+        for (size_t i = 0; i < count; i++)
+        {
+            starts[((list.order[i] >> shift) & 0xff) + 1]++;
+        }
+        for (int b = 0; b < 256; b++)
+        {
+            starts[b + 1] += starts[b];
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            list.scratch[starts[(list.order[i] >> shift) & 0xff]++] = list.order[i];
+        }
+        list.order.swap(list.scratch);
+    }
+}
+
+/**
+ * Checks the radix sort against a stable sort of the keys, on lists of
+ * random keys from only a few values, so most keys are shared and the
+ * order they were recorded in matters.
+ * 
+ * @return  false if a list was sorted differently, after writing which
+ */
+bool check_render_sort()
+{
+    const int lists = 50;
+    game_rng rng = new_rng(1);
+    render_list list;
+    vector<uint32_t> expected;
+
+    for (int l = 0; l < lists; l++)
+    {
+        clear_render_list(list);
+        size_t count = rng_int(rng, 0, 5000);
+        int values = 1 + l * 5;
+
+        // any bits but the low byte, which the sort does not look at
+        vector<uint32_t> keys(values);
+        for (int v = 0; v < values; v++)
+        {
+            keys[v] = (uint32_t)rng_next(rng) & 0xffffff00;
+        }
+
+        list.commands.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            list.commands[i].key = keys[rng_int(rng, 0, values)];
+        }
+
+        expected.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            expected[i] = i;
+        }
+        stable_sort(expected.begin(), expected.end(), [&](uint32_t a, uint32_t b) { return list.commands[a].key < list.commands[b].key; });
+
+        sort_render_list(list);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if ((uint32_t)list.order[i] != expected[i])
+            {
+                write_line("render list " + to_string(l) + " has command " + to_string((uint32_t)list.order[i]) + " at " + to_string(i) + " instead of " + to_string(expected[i]));
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+size_t count_render_runs(const render_list &list, bool sorted)
+{
+    size_t result = 0;
+    const render_command *last = nullptr;
+
+    for (size_t i = 0; i < list.commands.size(); i++)
+    {
+        const render_command &command = sorted ? list.commands[(uint32_t)list.order[i]] : list.commands[i];
+
+        // the key holds everything a run shares but the exact bitmap
+        if (not last or command.kind == RENDER_TEXT or command.key != last->key or command.image != last->image)
+            result++;
+        last = &command;
+    }
+    return result;
+}
+
+size_t submit_render_list(render_list &list)
+{
+    sort_render_list(list);
+    size_t calls = 0;
+
+    for (size_t i = 0; i < list.order.size(); i++)
+    {
+        const render_command &command = list.commands[(uint32_t)list.order[i]];
+
+        switch (command.kind)
+        {
+        case RENDER_BITMAP:
+            if (command.width > 0)
+                draw_bitmap(command.image, command.x, command.y, option_part_bmp(0, 0, command.width, command.height, option_to_screen()));
+            else if (command.scale != 1)
+                draw_bitmap(command.image, command.x, command.y, option_scale_bmp(command.scale, command.scale, option_to_screen()));
+            else
+                draw_bitmap(command.image, command.x, command.y, option_to_screen());
+            break;
+        case RENDER_FILL_RECTANGLE:
+            fill_rectangle(command.tint, command.x, command.y, command.width, command.height, option_to_screen());
+            break;
+        case RENDER_RECTANGLE:
+            draw_rectangle(command.tint, command.x, command.y, command.width, command.height, option_to_screen());
+            break;
+        case RENDER_PIXEL:
+            draw_pixel(command.tint, command.x, command.y, option_to_screen());
+            break;
+        case RENDER_TRIANGLE:
+            fill_triangle(command.tint, command.x, command.y, command.x2, command.y2, command.x3, command.y3, option_to_screen());
+            break;
+        case RENDER_TEXT:
+        {
+            const render_text &text = list.texts[command.text];
+            if (text.font.empty())
+                draw_text(text.words, command.tint, command.x, command.y, option_to_screen());
+            else
+                draw_text(text.words, command.tint, text.font, text.size, command.x, command.y, option_to_screen());
+            break;
+        }
+        }
+        calls++;
+    }
+    return calls;
+}
+
+//                                      ●▬▬▬▬   »»»       rotation.𝗵       «««  ▬▬▬▬▬●
+
+#define ROTATION_STEPS 32
+#define MIP_LEVELS 4
+
+/**
+ * One bit for each pixel of a bitmap, set where the pixel is drawn.
+ * Every row starts on a new word, so two masks are compared 64 pixels at a time.
+ * 
+ * @field   width, height   size of the bitmap
+ * @field   words           words in each row
+ * @field   bits            the rows, one after the other
+ */
+struct collision_mask
+{
+    int width, height;
+    int words;
+    vector<uint64_t> bits;
+};
+
+/**
+ * A bitmap turned to a number of headings once, when it is loaded, with the
+ * collision mask of every turn. The turns are squares big enough for the
+ * bitmap at any angle, all centred on the bitmap's centre, so a ship facing
+ * the way it moves is drawn with a plain blit and hit tests turn nothing.
+ * The bitmap faces up in turn 0, the turns go clockwise from there.
+ * Each turn is also shrunk to half its size over and over, so a zoomed out
+ * camera draws from a small bitmap instead of squeezing the full one.
+ * 
+ * @field   turns       the bitmap at each heading
+ * @field   mips        the turns at half the size of the level before, mips[level - 1][step]
+ * @field   masks       the collision mask of each turn
+ * @field   offset_x, offset_y  where the turns are drawn, from the top left of the unturned bitmap
+ */
+struct rotated_bitmap
+{
+    vector<bitmap> turns;
+    vector<vector<bitmap>> mips;
+    vector<collision_mask> masks;
+    int offset_x, offset_y;
+};
+
+/**
+ * Turns a bitmap to a number of evenly spread headings and shrinks
+ * each turn down to MIP_LEVELS sizes.
+ * 
+ * @param source    the bitmap facing up
+ * @param steps     headings to make, 1 for a bitmap that never turns
+ */
+rotated_bitmap new_rotated_bitmap(bitmap source, int steps);
+
+/**
+ * @return  the turn of a rotated bitmap nearest to the heading of a velocity,
+ *          0 when it does not move
+ */
+int heading_step(const rotated_bitmap &rotated, float dx, float dy);
+
+/**
+ * Draws one turn of a rotated bitmap into a frame. Below full size it is
+ * drawn from the smallest level that is still at least as big as the scale asks for.
+ * 
+ * @param frame         the frame being recorded
+ * @param layer         the layer to draw on
+ * @param rotated       the turned bitmaps
+ * @param step          the turn to draw
+ * @param centre_x, centre_y    where the centre of the bitmap goes on the screen
+ * @param scale         size to draw at, 1 for the full bitmap
+ */
+void draw_rotated(render_list &frame, render_layer layer, const rotated_bitmap &rotated, int step, float centre_x, float centre_y, float scale);
+
+/**
+ * Checks if two turned bitmaps have a drawn pixel in the same place.
+ * 
+ * @param a, b              the turned bitmaps
+ * @param a_step, b_step    the turn of each
+ * @param ax, ay, bx, by    top left of each unturned bitmap
+ */
+bool rotated_collision(const rotated_bitmap &a, int a_step, double ax, double ay, const rotated_bitmap &b, int b_step, double bx, double by);
+
+//                                      ●▬▬▬▬   »»»       rotation.cpp       «««  ▬▬▬▬▬●
+
+// every turned bitmap needs its own name in splashkit
+int rotated_bitmaps_created = 0;
+
+/**
+ * reads the drawn pixels of a bitmap into a mask, once the bitmap
+ * has its own collision mask in splashkit
+ */
+collision_mask new_collision_mask(bitmap bmp)
+{
+    collision_mask result;
+    result.width = bitmap_width(bmp);
+    result.height = bitmap_height(bmp);
+    result.words = (result.width + 63) / 64;
+    result.bits.assign((size_t)result.words * result.height, 0);
+
+    setup_collision_mask(bmp);
+    for (int y = 0; y < result.height; y++)
+    {
+        for (int x = 0; x < result.width; x++)
+        {
+            if (pixel_drawn_at_point(bmp, x, y))
+                result.bits[(size_t)y * result.words + x / 64] |= 1ULL << (x % 64);
+        }
+    }
+    return result;
+}
+
+rotated_bitmap new_rotated_bitmap(bitmap source, int steps)
+{
+    int width = bitmap_width(source), height = bitmap_height(source);
+    int size = (int)ceil(sqrt((double)width * width + (double)height * height));
+
+    rotated_bitmap result;
+    result.offset_x = (width - size) / 2;
+    result.offset_y = (height - size) / 2;
+    result.mips.resize(MIP_LEVELS - 1);
+
+    for (int step = 0; step < steps; step++)
+    {
+        bitmap turn = create_bitmap("turn_" + to_string(rotated_bitmaps_created++), size, size);
+        live_resources.bitmaps++;
+
+        clear_bitmap(turn, COLOR_TRANSPARENT);
+        draw_bitmap_on_bitmap(turn, source, -result.offset_x, -result.offset_y, option_rotate_bmp(360.0 * step / steps));
+
+        result.turns.push_back(turn);
+        result.masks.push_back(new_collision_mask(turn));
+
+        // bitmaps are scaled around their centre, so the turn is drawn up and left by what it loses
+        for (int level = 1; level < MIP_LEVELS; level++)
+        {
+            double scale = 1.0 / (1 << level);
+            int mip_size = (int)ceil(size * scale);
+            bitmap mip = create_bitmap("turn_" + to_string(rotated_bitmaps_created++), mip_size, mip_size);
+            live_resources.bitmaps++;
+
+            clear_bitmap(mip, COLOR_TRANSPARENT);
+            draw_bitmap_on_bitmap(mip, turn, -(size - mip_size) / 2.0, -(size - mip_size) / 2.0, option_scale_bmp(scale, scale));
+            result.mips[level - 1].push_back(mip);
+        }
+    }
+    return result;
+}
+
+int heading_step(const rotated_bitmap &rotated, float dx, float dy)
+{
+    int steps = (int)rotated.turns.size();
+    if (steps <= 1 or (dx == 0 and dy == 0))
+        return 0;
+
+    // clockwise from up, as y goes down the screen
+    float turns = atan2(dx, -dy) / (2 * M_PI);
+    int step = (int)lround(turns * steps) % steps;
+    return step < 0 ? step + steps : step;
+}
+
+void draw_rotated(render_list &frame, render_layer layer, const rotated_bitmap &rotated, int step, float centre_x, float centre_y, float scale)
+{
+    // every level halves the size, the level left over makes up the rest
+    int level = min(MIP_LEVELS - 1, max(0, (int)floor(-log2(scale))));
+    bitmap image = level == 0 ? rotated.turns[step] : rotated.mips[level - 1][step];
+    float rest = scale * (1 << level);
+
+    record_bitmap(frame, layer, image, centre_x - bitmap_width(image) / 2.0f, centre_y - bitmap_height(image) / 2.0f, rest);
+}
+
+/**
+ * 64 bits of a mask row starting at column x, which does not
+ * need to be on a word. bits past the end of the row are 0
+ */
+uint64_t mask_bits(const collision_mask &mask, int row, int x)
+{
+    const uint64_t *words = mask.bits.data() + (size_t)row * mask.words;
+    int word = x / 64, shift = x % 64;
+
+    uint64_t result = words[word] >> shift;
+    if (shift > 0 and word + 1 < mask.words)
+        result |= words[word + 1] << (64 - shift);
+    return result;
+}
+
+bool rotated_collision(const rotated_bitmap &a, int a_step, double ax, double ay, const rotated_bitmap &b, int b_step, double bx, double by)
+{
+    const collision_mask &mask_a = a.masks[a_step], &mask_b = b.masks[b_step];
+    int left_a = (int)floor(ax) + a.offset_x, top_a = (int)floor(ay) + a.offset_y;
+    int left_b = (int)floor(bx) + b.offset_x, top_b = (int)floor(by) + b.offset_y;
+
+    // the part of the screen both squares cover
+    int left = max(left_a, left_b), right = min(left_a + mask_a.width, left_b + mask_b.width);
+    int top = max(top_a, top_b), bottom = min(top_a + mask_a.height, top_b + mask_b.height);
+    if (left >= right or top >= bottom)
+        return false;
+
+    for (int y = top; y < bottom; y++)
+    {
+        for (int x = left; x < right; x += 64)
+        {
+            uint64_t both = mask_bits(mask_a, y - top_a, x - left_a) & mask_bits(mask_b, y - top_b, x - left_b);
+
+            // the last word can reach past the part both cover
+            if (right - x < 64)
+                both &= (1ULL << (right - x)) - 1;
+            if (both)
+                return true;
+        }
+    }
+    return false;
+}
+
+//                                      ●▬▬▬▬   »»»       𝗽𝗹𝗮𝘆𝗲𝗿.𝗵       «««  ▬▬▬▬▬●
+
+#define MAX_VEL 3
+#define WINDOW_WIDTH 1200
+#define WINDOW_HEIGHT 600
+#define PLAYER_WIDTH 101
+#define PLAYER_HEIGHT 74
+#define MAX_SPAWN 1000
+#define MIN_SPAWN -1000
+#define MAX_SPAWN_RANGE 2000
+#define MAX_ACTIVE_SPAWN 80
+#define SPAWN_RATE 1.2
+#define SHIELD_SECONDS 20
+#define HEADLESS_HIT_SCALE 0.8
+#define ZOOM_MIN 0.05f
+#define ZOOM_STEP 1.25f
+
+/**
+ * enum for the different parts of player 
+ * the main ship and the force field
+ */
+enum player_upgrade
+{
+    SHIELDED,
+    PLAYER
+};
+
+/**
+ * The player data keeps track of all of the information related to the player.
+ * 
+ * @field   ship            The player's ship at every heading - used to draw the player, empty when running without a window
+ * @field   heading         the turn of the ship drawn, kept while the player stands still
+ * @field   x, y            position of the top left of the player
+ * @field   dx, dy          velocity of the player
+ * @field   width, height   size of the player's ship
+ * @field   score           The current score for the player
+ * @field   upgrade         current upgrade on player ship
+ * @field   fuel_pct        the prcentage of fuel in player ship
+ * @field   shield          checks if player has shield or not
+ * @field   shield_count    counts the shields picked up, so an old shield's expiry can be ignored
+ * @field   game_over       checks if the player lost or not
+ * @field   camera          top left of the screen in the world at full size
+ * @field   zoom            how big the world is drawn, 1 for full size down to ZOOM_MIN
+ */
+struct player_data
+{
+    const rotated_bitmap *ship;
+    int heading;
+    float x, y;
+    float dx, dy;
+    float width, height;
+    int score;
+    player_upgrade upgrade;
+    double fuel_pct;
+    bool shield;
+    unsigned int shield_count;
+    bool game_over;
+    point_2d camera;
+    float zoom;
+};
+
+/**
+ * Turns the player's ship to every heading, after the resources are loaded.
+ */
+void load_player_bitmaps();
+
+/**
+ * Creates a new player in the centre of the screen with the default ship.
+ * 
+ * @param with_window   false when running without a window, the player then has no ship to draw
+ * @returns     The new player data
+ */
+player_data new_player(bool with_window);
+
+/**
+ * @return  the position of the centre of the player
+ */
+point_2d player_center(const player_data &player);
+
+/**
+ * Points the player towards a position at the fastest allowed speed.
+ * This is how both the mouse and the autopilot move the player.
+ * 
+ * @param player    The player to steer
+ * @param target    The position to head for
+ */
+void steer_player(player_data &player, const point_2d &target);
+
+/**
+ * Stops the player wherever it is.
+ * 
+ * @param player    The player to stop
+ */
+void stop_player(player_data &player);
+
+/**
+ * @return  the part of the world the player's camera has on the screen, bigger when zoomed out
+ */
+rectangle player_view(const player_data &player);
+
+/**
+ * Draws the player to the screen. 
+ * 
+ * @param player_to_draw    The player to draw to the screen
+ * @param frame             the frame being recorded
+ */
+void draw_player(const player_data &player_to_draw, render_list &frame);
+
+/**
+ * Actions a step update of the player - moving them and adjusting the camera.
+ * Every player has its own camera, the window is only moved to it when drawing.
+ * 
+ * @param player_to_update      The player being updated
+ */
+void update_player(player_data &player_to_update);
+
+/**
+ * Read user input and update the player based on this interaction.
+ * 
+ * @param player    The player to update
+ */
+void handle_input(player_data &player);
+
+//                                      ●▬▬▬▬   »»»       𝗽𝗹𝗮𝘆𝗲𝗿.cpp       «««  ▬▬▬▬▬●
+
+// the player's ship at every heading, filled by load_player_bitmaps
+rotated_bitmap player_ship;
+
+void load_player_bitmaps()
+{
+    player_ship = new_rotated_bitmap(bitmap_named("player"), ROTATION_STEPS);
+}
+
+player_data new_player(bool with_window)
+{
+    player_data result;
+    result.ship = with_window ? &player_ship : nullptr;
+    result.heading = 0;
+    result.width = PLAYER_WIDTH;
+    result.height = PLAYER_HEIGHT;
+    result.dx = 0;
+    result.dy = 0;
+    result.camera = point_at(0, 0);
+    result.zoom = 1;
+
+    // Position in the centre of the initial screen
+    result.x = (WINDOW_WIDTH - result.width) / 2;
+    result.y = (WINDOW_HEIGHT - result.height) / 2;
+
+    return result;
+}
+
+point_2d player_center(const player_data &player)
+{
+    return point_at(player.x + player.width / 2, player.y + player.height / 2);
+}
+
+void update_camera_position(point_2d &camera, double player_x, double player_y)
+{
+    // Test edge of screen boundaries to adjust the camera
+    // it is made so the edges are just the centre of the screen
+    // so the player remains in centre and world moves around him
+    double left_edge = camera.x + WINDOW_WIDTH / 2;
+    double right_edge = left_edge + WINDOW_WIDTH - 2 * (WINDOW_WIDTH / 2);
+    double top_edge = camera.y + WINDOW_HEIGHT / 2;
+    double bottom_edge = top_edge + WINDOW_HEIGHT - 2 * (WINDOW_HEIGHT / 2);
+
+    // Test if the player is outside the area and move the camera
+    // the player will appear to stay still and everything else
+    // will appear to move :)
+
+    // Test top/bottom of screen
+    if (player_y < top_edge)
+    {
+        camera.y += player_y - top_edge;
+    }
+    else if (player_y > bottom_edge)
+    {
+        camera.y += player_y - bottom_edge;
+    }
+
+    // Test left/right of screen
+    if (player_x < left_edge)
+    {
+        camera.x += player_x - left_edge;
+    }
+    else if (player_x > right_edge)
+    {
+        camera.x += player_x - right_edge;
+    }
+}
+
+rectangle player_view(const player_data &player)
+{
+    // the camera keeps the player in the middle, zooming out grows the view around it
+    double width = WINDOW_WIDTH / player.zoom, height = WINDOW_HEIGHT / player.zoom;
+    return rectangle_from(player.camera.x + (WINDOW_WIDTH - width) / 2, player.camera.y + (WINDOW_HEIGHT - height) / 2, width, height);
+}
+
+void draw_player(const player_data &player_to_draw, render_list &frame)
+{
+    // the player is drawn on the screen, shrunk around its centre when zoomed out
+    rectangle view = player_view(player_to_draw);
+    float zoom = player_to_draw.zoom;
+    point_2d center = player_center(player_to_draw);
+    draw_rotated(frame, LAYER_PLAYER, *player_to_draw.ship, player_to_draw.heading, (center.x - view.x) * zoom, (center.y - view.y) * zoom, zoom);
+
+    // the force field is only shown while the player has a shield,
+    // offset so it fits perfectly on the player
+    if (player_to_draw.shield)
+    {
+        bitmap field = bitmap_named("force_field");
+        float field_x = player_to_draw.x - 25 + bitmap_width(field) / 2.0f, field_y = player_to_draw.y - 35 + bitmap_height(field) / 2.0f;
+        record_bitmap(frame, LAYER_SHIELD, field, (field_x - view.x) * zoom - bitmap_width(field) / 2.0f, (field_y - view.y) * zoom - bitmap_height(field) / 2.0f, zoom);
+    }
+}
+
+void update_player(player_data &player_to_update)
+{
+    point_2d center = player_center(player_to_update);
+
+    player_to_update.x += player_to_update.dx;
+    player_to_update.y += player_to_update.dy;
+
+    update_camera_position(player_to_update.camera, center.x, center.y);
+
+    // a player standing still keeps facing the way it last went
+    if (player_to_update.ship and (player_to_update.dx != 0 or player_to_update.dy != 0))
+        player_to_update.heading = heading_step(*player_to_update.ship, player_to_update.dx, player_to_update.dy);
+}
+
+void steer_player(player_data &player, const point_2d &target)
+{
+    // makes a vector out of the player and target position
+    // and also caps it with a limit.
+    vector_2d vel = vector_limit(vector_point_to_point(player_center(player), target), MAX_VEL);
+    player.dx = vel.x;
+    player.dy = vel.y;
+}
+
+void stop_player(player_data &player)
+{
+    // by making velocity value 0
+    player.dx = 0;
+    player.dy = 0;
+}
+
+void handle_input(player_data &player)
+{
+    point_2d loc_play, loc_mouse, pos;
+
+    if (mouse_down(LEFT_BUTTON)) // code executed only if LMB is down
+    {
+        loc_play = player_center(player); // position of player's center
+        loc_mouse = mouse_position();     // position of mouse
+
+        // makes the mouse position relative to player rather than the screen,
+        // a zoomed out screen covers more of the world
+        pos.x = loc_play.x + (loc_mouse.x - screen_width() / 2) / player.zoom;
+        pos.y = loc_play.y + (loc_mouse.y - screen_height() / 2) / player.zoom;
+
+        steer_player(player, pos);
+    }
+    else if (mouse_clicked(RIGHT_BUTTON)) // code executed only if RMB is clicked
+    {
+        // stops the player wherever it is
+        stop_player(player);
+    }
+
+    // each notch of the wheel zooms by the same step, out to the strategic view
+    float notches = mouse_wheel_scroll().y;
+    if (notches != 0)
+        player.zoom = clamp(player.zoom * pow(ZOOM_STEP, notches), ZOOM_MIN, 1.0f);
+}
+
+//                                      ●▬▬▬▬   »»»       entity.𝗵       «««  ▬▬▬▬▬●
+
+/**
+ * Different options for the spawning entities.
+ * Adjusts the image used.
+ */
+enum entity_type
+{
+    SHIELD,
+    STAR,
+    FUEL,
+    ALLY_1,
+    ALLY_2,
+    ALLY_3,
+    ALLY_4,
+    FOE,
+    ENTITY_TYPE_COUNT
+};
+
+/**
+ * The components an entity can have. An entity's components decide which
+ * systems work on it, instead of checking its type in every loop.
+ */
+enum component_kind
+{
+    KINEMATIC = 1 << 0,     // moves by its velocity every update
+    PICKUP = 1 << 1,        // is collected when the player touches it
+    HOSTILE = 1 << 2,       // hurts the player when touched
+    STATIC = 1 << 3,        // stays where it spawned
+    MINIMAP_COLOR = 1 << 4, // is shown on the minimap
+    TURNS = 1 << 5          // is drawn facing the way it moves
+};
+
+/**
+ * Everything that makes one type of entity different from the others.
+ * 
+ * @field   bitmap_name     name of the entity's bitmap in the resource bundle
+ * @field   width, height   size of the bitmap, so entities have a size even without a window
+ * @field   components      the components the entity gets
+ * @field   score           added to the score when the player picks it up
+ * @field   fuel            fuel percentage added when the player picks it up
+ * @field   shield          gives the player a shield when picked up
+ * @field   lifetime        seconds an entity spawned near the player stays for, 0 if it never leaves
+ * @field   minimap_color   the colour used for it on the minimap
+ * @field   sounds          sounds played when the player touches it, one is picked at random
+ * @field   sound_count     number of sounds in the list
+ */
+struct entity_archetype
+{
+    const char *bitmap_name;
+    int width, height;
+    unsigned int components;
+    int score;
+    double fuel;
+    bool shield;
+    double lifetime;
+    color minimap_color;
+    const char *sounds[3];
+    int sound_count;
+};
+
+// foes are red, power ups are green and allies are cyan
+constexpr color MINIMAP_FOE = {1.0f, 0.0f, 0.0f, 0.94f};
+constexpr color MINIMAP_POWER_UP = {0.0f, 1.0f, 0.0f, 0.94f};
+constexpr color MINIMAP_ALLY = {0.0f, 1.0f, 1.0f, 0.94f};
+
+/**
+ * One row per entity type, in the same order as entity_type.
+ * Adding a new type of entity only needs a new enum value, a row here
+ * and its bitmap in the resource bundle.
+ * 
+ * the allies say 'thank you' in spanish, hindi and japanese
+ * (offcourse in their alien sounds)
+ */
+constexpr entity_archetype ENTITY_ARCHETYPES[] = {
+    // bitmap   size        components                                      score   fuel    shield  lifetime    minimap             sounds
+    {"shield",  100, 100,   KINEMATIC | PICKUP | MINIMAP_COLOR,             0,      0,      true,   30,         MINIMAP_POWER_UP,   {"activated"}, 1},
+    {"star",    100, 100,   KINEMATIC | PICKUP | MINIMAP_COLOR,             30,     0,      false,  30,         MINIMAP_POWER_UP,   {"star"}, 1},
+    {"fuel",    100, 100,   KINEMATIC | PICKUP | MINIMAP_COLOR,             0,      0.25,   false,  30,         MINIMAP_POWER_UP,   {"fuel"}, 1},
+    {"ally_1",  101, 116,   STATIC | PICKUP | MINIMAP_COLOR,                10,     0,      false,  0,          MINIMAP_ALLY,       {"thanks1", "thanks2", "thanks3"}, 3},
+    {"ally_2",  101, 126,   STATIC | PICKUP | MINIMAP_COLOR,                10,     0,      false,  0,          MINIMAP_ALLY,       {"thanks1", "thanks2", "thanks3"}, 3},
+    {"ally_3",  101, 148,   STATIC | PICKUP | MINIMAP_COLOR,                10,     0,      false,  0,          MINIMAP_ALLY,       {"thanks1", "thanks2", "thanks3"}, 3},
+    {"ally_4",  108, 101,   STATIC | PICKUP | MINIMAP_COLOR,                10,     0,      false,  0,          MINIMAP_ALLY,       {"thanks1", "thanks2", "thanks3"}, 3},
+    {"foe",     101, 90,    KINEMATIC | HOSTILE | TURNS | MINIMAP_COLOR,    0,      0,      false,  45,         MINIMAP_FOE,        {"hit"}, 1},
+};
+
+static_assert(sizeof(ENTITY_ARCHETYPES) / sizeof(ENTITY_ARCHETYPES[0]) == ENTITY_TYPE_COUNT, "every entity type needs exactly one archetype row");
+
+/**
+ * Checks at compile time that every row either moves or stays still,
+ * and that the sound list is not empty.
+ */
+constexpr bool archetypes_valid()
+{
+    for (int i = 0; i < ENTITY_TYPE_COUNT; i++)
+    {
+        bool kinematic = ENTITY_ARCHETYPES[i].components & KINEMATIC;
+        bool still = ENTITY_ARCHETYPES[i].components & STATIC;
+
+        if (kinematic == still or ENTITY_ARCHETYPES[i].sound_count < 1 or ENTITY_ARCHETYPES[i].sound_count > 3)
+            return false;
+    }
+    return true;
+}
+
+static_assert(archetypes_valid(), "an entity archetype row is not valid");
+
+/**
+ * @return  the biggest width or height of any entity type, worked out at compile time
+ */
+constexpr int entity_max_extent()
+{
+    int result = 0;
+    for (int i = 0; i < ENTITY_TYPE_COUNT; i++)
+    {
+        result = max(result, max(ENTITY_ARCHETYPES[i].width, ENTITY_ARCHETYPES[i].height));
+    }
+    return result;
+}
+
+/**
+ * The entity data describes a single entity when it is spawned or saved.
+ * While it is in the game it lives in the entity store instead.
+ * 
+ * @field   type        the type of entity
+ * @field   x, y        position of the top left of the entity
+ * @field   dx, dy      velocity of the entity
+ */
+struct entity_data
+{
+    entity_type type;
+    float x, y;
+    float dx, dy;
+};
+
+#define ENTITY_MAX_INTERVAL 8
+
+/**
+ * The entity store keeps all the entities of the game as separate arrays
+ * (one entry per entity in each), so updates can run over them in one go.
+ * Entities have no sprite of their own, they are drawn with their type's bitmap.
+ * 
+ * @field   x, y            positions of the top left of the entities
+ * @field   dx, dy          velocities of the entities
+ * @field   width, height   size of the entities' bitmaps
+ * @field   type            the type of each entity
+ * @field   minimap_color   the colour each entity is shown with on the minimap
+ * @field   id              a number that stays with each entity while it is active
+ * @field   dead            marks the entities to remove at the end of the update
+ * @field   interval        updates between the moves of each entity, 1 to move every update or 0 when asleep
+ */
+struct entity_store
+{
+    vector<float> x, y;
+    vector<float> dx, dy;
+    vector<float> width, height;
+    vector<entity_type> type;
+    vector<color> minimap_color;
+    vector<unsigned int> id;
+    vector<uint8_t> dead;
+    vector<float> interval;
+};
+
+/**
+ * Creates a new entity at a random location on the screen.
+ * 
+ * @param x a random point in x axes
+ * @param y a random point in y axes
+ * @param rng   the random numbers of the game
+ */
+entity_data entity_spawn(double x, double y, game_rng &rng);
+
+/**
+ * Creates a new entity of a type that was already chosen.
+ * 
+ * @param type  the type of entity
+ * @param x     a random point in x axes
+ * @param y     a random point in y axes
+ * @param rng   the random numbers of the game
+ */
+entity_data entity_spawn(entity_type type, double x, double y, game_rng &rng);
+
+/**
+ * The spawn_chance uses the spawn table to choose 
+ * the type of entity to spawn 
+ * 
+ * @param rng   the random numbers of the game
+ * @return      the type of entity choosen through the spawn weights
+ */
+entity_type spawn_chance(game_rng &rng);
+
+/**
+ * Creates an entity of a known type with a known position and velocity.
+ * Used when restoring entities that were saved with their chunk.
+ * 
+ * @param type  the type of entity
+ * @param x     position in x axes
+ * @param y     position in y axes
+ * @param dx    velocity in x axes
+ * @param dy    velocity in y axes
+ */
+entity_data create_entity(entity_type type, double x, double y, double dx, double dy);
+
+/**
+ * The entity_turns function converts a entity type into the 
+ * turned bitmaps that can be used.
+ * 
+ * @param type  The type of entity
+ * @return      The bitmap of this entity type at every heading, only one unless it TURNS
+ */
+const rotated_bitmap &entity_turns(entity_type type);
+
+/**
+ * @return  the turn an entity is drawn and hit tested with
+ */
+int entity_heading(const entity_store &store, size_t idx);
+
+/**
+ * Looks up and turns the bitmap of every entity type once, after the resources
+ * are loaded, so entity_turns does not need to search for it by name.
+ */
+void load_entity_bitmaps();
+
+/**
+ * Decides the components an entity of a given type gets.
+ * 
+ * @param type  the type of entity
+ */
+unsigned int entity_components(entity_type type);
+
+/**
+ * Gives the colour an entity type is shown with on the minimap.
+ * 
+ * @param type  The type of entity
+ */
+color entity_minimap_color(entity_type type);
+
+/**
+ * Adds an entity to the end of the store.
+ * 
+ * @param store     the store to add to
+ * @param entity    the entity being added
+ * @param id        the id given to the entity
+ */
+void add_entity(entity_store &store, const entity_data &entity, unsigned int id);
+
+/**
+ * Reads one entity back out of the store.
+ * 
+ * @param store     the store to read from
+ * @param idx       index of the entity in the store
+ */
+entity_data entity_at(const entity_store &store, size_t idx);
+
+/**
+ * @return  the number of entities in the store
+ */
+size_t entity_count(const entity_store &store);
+
+/**
+ * Draws the entities of the store from first up to last inside a view to the screen.
+ * 
+ * @param store     the entities to draw
+ * @param first, last   the entities drawn, last not included
+ * @param view      the part of the world on the screen
+ * @param zoom      how big the world is drawn, below 1 the entities are drawn shrunk from their mips
+ * @param frame     the frame being recorded
+ */
+void draw_entities(const entity_store &store, size_t first, size_t last, const rectangle &view, float zoom, render_list &frame);
+
+/**
+ * Actions an update of all the entities - 
+ * moving each entity by its velocity. Entities with a longer interval
+ * only move on the updates it divides, by all the velocity they missed.
+ * 
+ * @param store     the entities being updated
+ * @param tick      number of the update, to work out whose turn it is
+ */
+void update_entities(entity_store &store, unsigned long long tick);
+
+/**
+ * Removes every entity marked as dead in one pass.
+ * The entities that are left keep their order.
+ * 
+ * @param store     the entities to compact
+ */
+void remove_dead_entities(entity_store &store);
+
+/**
+ * Removes every entity from the store.
+ * 
+ * @param store     the entities to clear
+ */
+void clear_entities(entity_store &store);
+
+//                                      ●▬▬▬▬   »»»       entity.cpp       «««  ▬▬▬▬▬●
+
+// the bitmap of each entity type at every heading, filled by load_entity_bitmaps
+rotated_bitmap entity_bitmaps[ENTITY_TYPE_COUNT];
+
+void load_entity_bitmaps()
+{
+    for (int i = 0; i < ENTITY_TYPE_COUNT; i++)
+    {
+        int steps = ENTITY_ARCHETYPES[i].components & TURNS ? ROTATION_STEPS : 1;
+        entity_bitmaps[i] = new_rotated_bitmap(bitmap_named(ENTITY_ARCHETYPES[i].bitmap_name), steps);
+    }
+}
+
+const rotated_bitmap &entity_turns(entity_type type)
+{
+    return entity_bitmaps[type];
+}
+
+int entity_heading(const entity_store &store, size_t idx)
+{
+    return heading_step(entity_turns(store.type[idx]), store.dx[idx], store.dy[idx]);
+}
+
+unsigned int entity_components(entity_type type)
+{
+    return ENTITY_ARCHETYPES[type].components;
+}
+
+color entity_minimap_color(entity_type type)
+{
+    return ENTITY_ARCHETYPES[type].minimap_color;
+}
+
+entity_data create_entity(entity_type type, double x, double y, double dx, double dy)
+{
+    entity_data result;
+    result.type = type;
+    result.x = x;
+    result.y = y;
+    result.dx = dx;
+    result.dy = dy;
+    return result;
+}
+
+entity_data entity_spawn(double x, double y, game_rng &rng)
+{
+    return entity_spawn(spawn_chance(rng), x, y, rng);
+}
+
+entity_data entity_spawn(entity_type type, double x, double y, game_rng &rng)
+{
+    // sets a random location of the entity on the screen
+    entity_data result = create_entity(type, x, y, 0, 0);
+
+    /**
+     * @brief 'if' statement checks if the spawn entity is not static
+     * 
+     * I have made my game such that the allies don't move and stay 
+     * at the location they spawn, so this 'if' block helps me with that.
+     * 
+     * entities that are kinematic go through the 'if' block
+     * and get random velocities.
+     */
+    if (entity_components(type) & KINEMATIC)
+    {
+        // sets a random speed of the entity
+        result.dx = rng_float(rng) * 4 - 2;
+        result.dy = rng_float(rng) * 4 - 2;
+    }
+    return result;
+}
+
+void add_entity(entity_store &store, const entity_data &entity, unsigned int id)
+{
+    store.x.push_back(entity.x);
+    store.y.push_back(entity.y);
+    store.dx.push_back(entity.dx);
+    store.dy.push_back(entity.dy);
+    store.width.push_back(ENTITY_ARCHETYPES[entity.type].width);
+    store.height.push_back(ENTITY_ARCHETYPES[entity.type].height);
+    store.type.push_back(entity.type);
+    store.minimap_color.push_back(entity_minimap_color(entity.type));
+    store.id.push_back(id);
+    store.dead.push_back(false);
+    store.interval.push_back(1);
+}
+
+entity_data entity_at(const entity_store &store, size_t idx)
+{
+    return create_entity(store.type[idx], store.x[idx], store.y[idx], store.dx[idx], store.dy[idx]);
+}
+
+size_t entity_count(const entity_store &store)
+{
+    return store.type.size();
+}
+
+void draw_entities(const entity_store &store, size_t first, size_t last, const rectangle &view, float zoom, render_list &frame)
+{
+    for (size_t i = first; i < last; i++)
+    {
+        // shot down at the end of the last update, they are removed in this one
+        if (store.dead[i])
+            continue;
+
+        if (store.x[i] > view.x + view.width or store.y[i] > view.y + view.height or store.x[i] + store.width[i] < view.x or store.y[i] + store.height[i] < view.y)
+            continue;
+
+        float sx = (store.x[i] + store.width[i] / 2 - view.x) * zoom, sy = (store.y[i] + store.height[i] / 2 - view.y) * zoom;
+        draw_rotated(frame, LAYER_SHIPS, entity_turns(store.type[i]), entity_heading(store, i), sx, sy, zoom);
+    }
+}
+
+/**
+ * Moves each position whose interval is due by its velocity times the interval,
+ * eight at a time with AVX or four at a time with SSE, finishing the rest one by one.
+ * An interval of 0 is always "due" but moves by nothing.
+ * 
+ * @param pos       the positions being moved
+ * @param vel       the velocities to move by
+ * @param interval  updates between the moves of each position
+ * @param due       the longest interval that moves this update
+ * @param count     number of positions
+ */
+void integrate_positions(float *pos, const float *vel, const float *interval, float due, size_t count)
+{
+    size_t i = 0;
+
+#if defined(__AVX__)
+    __m256 due8 = _mm256_set1_ps(due);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 every = _mm256_loadu_ps(interval + i);
+        __m256 step = _mm256_and_ps(_mm256_cmp_ps(every, due8, _CMP_LE_OQ), every);
+        _mm256_storeu_ps(pos + i, _mm256_add_ps(_mm256_loadu_ps(pos + i), _mm256_mul_ps(_mm256_loadu_ps(vel + i), step)));
+    }
+#endif
+#if defined(__SSE2__)
+    __m128 due4 = _mm_set1_ps(due);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 every = _mm_loadu_ps(interval + i);
+        __m128 step = _mm_and_ps(_mm_cmple_ps(every, due4), every);
+        _mm_storeu_ps(pos + i, _mm_add_ps(_mm_loadu_ps(pos + i), _mm_mul_ps(_mm_loadu_ps(vel + i), step)));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        if (interval[i] <= due)
+            pos[i] += vel[i] * interval[i];
+    }
+}
+
+void update_entities(entity_store &store, unsigned long long tick)
+{
+    // the intervals are powers of two, the ones due are those dividing the tick.
+    // a move covers the updates until the next one, and the intervals are only
+    // changed on multiples of ENTITY_MAX_INTERVAL, so no update is lost or moved twice
+    float due = (float)(tick & (~tick + 1));
+    if (tick == 0 or due > ENTITY_MAX_INTERVAL)
+        due = ENTITY_MAX_INTERVAL;
+
+    integrate_positions(store.x.data(), store.dx.data(), store.interval.data(), due, entity_count(store));
+    integrate_positions(store.y.data(), store.dy.data(), store.interval.data(), due, entity_count(store));
+}
+
+void remove_dead_entities(entity_store &store)
+{
+    // most updates nothing died, and everything before the first dead entity stays put
+    size_t kept = find(store.dead.begin(), store.dead.end(), 1) - store.dead.begin();
+    if (kept == entity_count(store))
+        return;
+
+    for (size_t i = kept + 1; i < entity_count(store); i++)
+    {
+        if (store.dead[i])
+            continue;
+
+        store.x[kept] = store.x[i];
+        store.y[kept] = store.y[i];
+        store.dx[kept] = store.dx[i];
+        store.dy[kept] = store.dy[i];
+        store.width[kept] = store.width[i];
+        store.height[kept] = store.height[i];
+        store.type[kept] = store.type[i];
+        store.minimap_color[kept] = store.minimap_color[i];
+        store.id[kept] = store.id[i];
+        store.dead[kept] = false;
+        store.interval[kept] = store.interval[i];
+        kept++;
+    }
+
+    store.x.resize(kept);
+    store.y.resize(kept);
+    store.dx.resize(kept);
+    store.dy.resize(kept);
+    store.width.resize(kept);
+    store.height.resize(kept);
+    store.type.resize(kept);
+    store.minimap_color.resize(kept);
+    store.id.resize(kept);
+    store.dead.resize(kept);
+    store.interval.resize(kept);
+}
+
+void clear_entities(entity_store &store)
+{
+    store.dead.assign(entity_count(store), true);
+    remove_dead_entities(store);
+}
+
+//                                      ●▬▬▬▬   »»»       spawn_table.𝗵       «««  ▬▬▬▬▬●
+
+#define SPAWN_WEIGHTS_FILE "spawn_weights.json"
+#define SPAWN_RELOAD_FRAMES 60
+
+/**
+ * A Walker alias table for picking the type of spawned entities.
+ * Each slot is picked with the same chance, then either keeps its own type
+ * or gives its alias, so one random number picks a type in constant time.
+ * 
+ * @field   keep        chance that a slot keeps its own type
+ * @field   alias       the type given by a slot when it does not keep its own
+ * @field   weights     the weights the table was built from, by type
+ */
+struct spawn_table
+{
+    double keep[ENTITY_TYPE_COUNT];
+    entity_type alias[ENTITY_TYPE_COUNT];
+    double weights[ENTITY_TYPE_COUNT];
+};
+
+/**
+ * Builds the alias table for a set of weights.
+ * 
+ * @param weights   weight of each entity type, they do not need to add up to 1
+ * @param table     the table being built
+ * @return          false if no weight is above zero (the table is left untouched)
+ */
+bool build_spawn_table(const double weights[ENTITY_TYPE_COUNT], spawn_table &table);
+
+/**
+ * Reads the spawn weights from the json file in Resources/json and builds the
+ * spawn table from them. Types missing from the file never spawn.
+ * 
+ * @return  false if the file could not be used, the current table is kept then
+ */
+bool load_spawn_table();
+
+/**
+ * Loads the spawn weights file again if it changed since it was last loaded.
+ */
+void reload_spawn_table();
+
+/**
+ * Checks every few calls if the spawn weights file changed and loads it again,
+ * so the weights can be tuned while the game is running. Called every frame,
+ * the file is only looked at once every SPAWN_RELOAD_FRAMES frames.
+ */
+void reload_spawn_table_if_changed();
+
+/**
+ * Picks the types for a group of entities spawned together.
+ * 
+ * @param count     number of types to pick
+ * @param types     the picked types are added to the end of this
+ * @param rng       the random numbers of the game
+ */
+void sample_spawn_types(int count, vector<entity_type> &types, game_rng &rng);
+
+//                                      ●▬▬▬▬   »»»       spawn_table.cpp       «««  ▬▬▬▬▬●
+
+/**
+ * The table used by spawn_chance. It starts out with the weights the game
+ * always had so it works even before the file is loaded.
+ */
+spawn_table current_spawn_table = []() {
+    spawn_table result;
+    const double defaults[ENTITY_TYPE_COUNT] = {0.1633, 0.1633, 0.1634, 0.075, 0.075, 0.075, 0.075, 0.21};
+    build_spawn_table(defaults, result);
+    return result;
+}();
+
+// the time the weights file was changed when it was last loaded
+filesystem::file_time_type spawn_weights_time;
+
+bool build_spawn_table(const double weights[ENTITY_TYPE_COUNT], spawn_table &table)
+{
+    double total = 0;
+    for (int i = 0; i < ENTITY_TYPE_COUNT; i++)
+    {
+        total += max(0.0, weights[i]);
+    }
+
+    if (total <= 0)
+        return false;
+
+    // scale the weights so an average slot has exactly 1
+    double scaled[ENTITY_TYPE_COUNT];
+    vector<int> small, large;
+
+    for (int i = 0; i < ENTITY_TYPE_COUNT; i++)
+    {
+        table.weights[i] = max(0.0, weights[i]);
+        scaled[i] = table.weights[i] * ENTITY_TYPE_COUNT / total;
+
+        if (scaled[i] < 1)
+            small.push_back(i);
+        else
+            large.push_back(i);
+    }
+
+    // fill each small slot up to 1 with the chance left over in a large one
+    while (not small.empty() and not large.empty())
+    {
+        int less = small.back();
+        int more = large.back();
+        small.pop_back();
+
+        table.keep[less] = scaled[less];
+        table.alias[less] = static_cast<entity_type>(more);
+
+        scaled[more] -= 1 - scaled[less];
+        if (scaled[more] < 1)
+        {
+            large.pop_back();
+            small.push_back(more);
+        }
+    }
+
+    // whatever is left is 1 give or take rounding
+    for (size_t i = 0; i < large.size(); i++)
+    {
+        table.keep[large[i]] = 1;
+        table.alias[large[i]] = static_cast<entity_type>(large[i]);
+    }
+    for (size_t i = 0; i < small.size(); i++)
+    {
+        table.keep[small[i]] = 1;
+        table.alias[small[i]] = static_cast<entity_type>(small[i]);
+    }
+
+    return true;
+}
+
+bool load_spawn_table()
+{
+    string path = path_to_resource(SPAWN_WEIGHTS_FILE, JSON_RESOURCE);
+
+    error_code err;
+    filesystem::file_time_type changed = filesystem::last_write_time(path, err);
+    if (err)
+        return false;
+    spawn_weights_time = changed;
+
+    json config = json_from_file(SPAWN_WEIGHTS_FILE);
+    bool loaded = false;
+
+    if (json_has_key(config, "weights"))
+    {
+        json weights = json_read_object(config, "weights");
+        double values[ENTITY_TYPE_COUNT];
+
+        for (int i = 0; i < ENTITY_TYPE_COUNT; i++)
+        {
+            values[i] = json_has_key(weights, ENTITY_ARCHETYPES[i].bitmap_name) ? json_read_number_as_double(weights, ENTITY_ARCHETYPES[i].bitmap_name) : 0;
+        }
+
+        // the new table is only used if it is valid, so a bad edit keeps the game running
+        spawn_table table;
+        loaded = build_spawn_table(values, table);
+        if (loaded)
+            current_spawn_table = table;
+
+        free_json(weights);
+    }
+
+    free_json(config);
+
+    if (not loaded)
+        write_line("spawn weights in " + path + " are not valid, keeping the current ones");
+    return loaded;
+}
+
+void reload_spawn_table()
+{
+    error_code err;
+    filesystem::file_time_type changed = filesystem::last_write_time(path_to_resource(SPAWN_WEIGHTS_FILE, JSON_RESOURCE), err);
+
+    if (not err and changed != spawn_weights_time)
+        load_spawn_table();
+}
+
+void reload_spawn_table_if_changed()
+{
+    static int frames = 0;
+    if (++frames < SPAWN_RELOAD_FRAMES)
+        return;
+    frames = 0;
+
+    reload_spawn_table();
+}
+
+/**
+ * Picks a type with one random number: the whole part chooses the slot
+ * and the fraction decides between the slot and its alias.
+ */
+entity_type sample_spawn_table(const spawn_table &table, double random)
+{
+    double slot = random * ENTITY_TYPE_COUNT;
+    int idx = min((int)slot, ENTITY_TYPE_COUNT - 1);
+
+    return slot - idx < table.keep[idx] ? static_cast<entity_type>(idx) : table.alias[idx];
+}
+
+entity_type spawn_chance(game_rng &rng)
+{
+    return sample_spawn_table(current_spawn_table, rng_float(rng));
+}
+
+void sample_spawn_types(int count, vector<entity_type> &types, game_rng &rng)
+{
+    const spawn_table &table = current_spawn_table;
+
+    for (int i = 0; i < count; i++)
+    {
+        types.push_back(sample_spawn_table(table, rng_float(rng)));
+    }
+}
+
+/**
+ * Checks the alias table against the weights it was built from, on random
+ * weights where some types get none. The chance of each type worked out
+ * from the slots has to be its share of the weights, and picking with
+ * evenly spread numbers has to come out close to that share.
+ * 
+ * @return  false if a table is off, after writing which
+ */
+bool check_spawn_table()
+{
+    const int tables = 200;
+    const int picks = 100000;
+    game_rng rng = new_rng(1);
+
+    double none[ENTITY_TYPE_COUNT] = {0};
+    spawn_table table;
+    if (build_spawn_table(none, table))
+    {
+        write_line("spawn table was built from weights that are all 0");
+        return false;
+    }
+
+    for (int t = 0; t < tables; t++)
+    {
+        double weights[ENTITY_TYPE_COUNT];
+        double total = 0;
+        for (int i = 0; i < ENTITY_TYPE_COUNT; i++)
+        {
+            weights[i] = rng_int(rng, 0, 4) == 0 ? 0 : rng_float(rng) * (t % 2 == 0 ? 1 : 1000);
+            total += weights[i];
+        }
+        if (total == 0)
+            continue;
+
+        build_spawn_table(weights, table);
+
+        double chance[ENTITY_TYPE_COUNT] = {0};
+        int counts[ENTITY_TYPE_COUNT] = {0};
+        for (int slot = 0; slot < ENTITY_TYPE_COUNT; slot++)
+        {
+            chance[slot] += table.keep[slot] / ENTITY_TYPE_COUNT;
+            chance[table.alias[slot]] += (1 - table.keep[slot]) / ENTITY_TYPE_COUNT;
+        }
+        for (int p = 0; p < picks; p++)
+        {
+            counts[sample_spawn_table(table, (p + 0.5) / picks)]++;
+        }
+
+        for (int i = 0; i < ENTITY_TYPE_COUNT; i++)
+        {
+            double share = weights[i] / total;
+            bool spawned = counts[i] > 0;
+
+            if (fabs(chance[i] - share) > 1e-9 or fabs((double)counts[i] / picks - share) > 1e-4 or (weights[i] == 0 and spawned))
+            {
+                write_line("spawn table " + to_string(t) + " gives " + ENTITY_ARCHETYPES[i].bitmap_name + " " + to_string(chance[i]) + " of the spawns (" + to_string((double)counts[i] / picks) + " picked) instead of " + to_string(share));
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+//                                      ●▬▬▬▬   »»»       ecs.𝗵       «««  ▬▬▬▬▬●
+
+#define ECS_PARALLEL_MIN 2048
+
+/**
+ * The data a system can read or write. Two systems that write the same data,
+ * or where one writes what the other reads, can not run at the same time.
+ * The first ones are kept in every archetype, the ones in ACCESS_GAME are
+ * single fields of the game shared by all the archetypes.
+ */
+enum access_kind
+{
+    ACCESS_POSITION = 1 << 0,
+    ACCESS_VELOCITY = 1 << 1,
+    ACCESS_DEAD = 1 << 2,
+    ACCESS_FAR = 1 << 3,
+    ACCESS_INTERVAL = 1 << 4,
+    ACCESS_PLAYER = 1 << 5,
+    ACCESS_PICKUPS = 1 << 6,
+    ACCESS_STATIC_PICKUPS = 1 << 7,
+    ACCESS_HITS = 1 << 8
+};
+
+// the data that belongs to the game, not to an archetype
+constexpr unsigned int ACCESS_GAME = ACCESS_PLAYER | ACCESS_PICKUPS | ACCESS_STATIC_PICKUPS | ACCESS_HITS;
+
+/**
+ * An archetype holds every entity with exactly the same components.
+ * 
+ * @field   components  the components of the entities in this archetype
+ * @field   entities    the entities themselves
+ * @field   far         set by the range system for entities outside the active chunks
+ */
+struct archetype_data
+{
+    unsigned int components;
+    entity_store entities;
+    vector<uint8_t> far;
+};
+
+/**
+ * The entity registry holds the archetypes of all the entities in the game.
+ * 
+ * @field   archetypes      one archetype for every set of components in use
+ * @field   next_id         the id the next added entity gets
+ * @field   static_changes  counts the times static entities were added or removed,
+ *                          so anything built from them knows when to rebuild
+ */
+struct entity_registry
+{
+    vector<archetype_data> archetypes;
+    unsigned int next_id;
+    unsigned long long static_changes;
+};
+
+struct game_data;
+
+/**
+ * @return  the pool the game's work is split over, nullptr to do it all on one thread
+ */
+worker_pool *game_pool(const game_data &game);
+
+/**
+ * A system is the code run over all the archetypes that match its query.
+ * 
+ * @field   name        name of the system, for debugging
+ * @field   with        components an archetype needs to match
+ * @field   without     components an archetype must not have to match
+ * @field   reads       data the system reads
+ * @field   writes      data the system writes
+ * @field   run         called once for every matching archetype
+ */
+struct system_data
+{
+    string name;
+    unsigned int with, without;
+    unsigned int reads, writes;
+    void (*run)(game_data &game, archetype_data &archetype);
+};
+
+/**
+ * The scheduler groups the systems into stages. Systems in the same stage
+ * do not conflict and can run on separate threads, the stages run in order.
+ * 
+ * @field   systems     the systems in the order they were added
+ * @field   stages      indexes of the systems in each stage
+ */
+struct scheduler_data
+{
+    vector<system_data> systems;
+    vector<vector<int>> stages;
+};
+
+/**
+ * Adds an entity to the archetype matching its components.
+ * 
+ * @param registry  the registry to add to
+ * @param entity    the entity being added
+ * @return          the id given to the entity
+ */
+unsigned int spawn_into(entity_registry &registry, const entity_data &entity);
+
+/**
+ * @return  the number of entities in all the archetypes
+ */
+size_t total_entities(const entity_registry &registry);
+
+/**
+ * Removes the dead entities from every archetype.
+ */
+void remove_dead_entities(entity_registry &registry);
+
+/**
+ * Removes every entity from every archetype.
+ */
+void clear_entities(entity_registry &registry);
+
+/**
+ * Checks if an archetype has the components a system asks for.
+ */
+bool archetype_matches(const archetype_data &archetype, unsigned int with, unsigned int without);
+
+/**
+ * Adds a system to the scheduler and places it in the first stage after
+ * every earlier system it conflicts with.
+ * 
+ * @param scheduler     the scheduler to add to
+ * @param system        the system being added
+ */
+void add_system(scheduler_data &scheduler, const system_data &system);
+
+/**
+ * Runs every stage of systems over the game. The systems of a stage run on
+ * the game's worker pool once there are enough entities to be worth it.
+ * 
+ * @param scheduler     the systems to run
+ * @param game          the game they run on
+ * @param registry      the entities of that game
+ */
+void run_systems(const scheduler_data &scheduler, game_data &game, entity_registry &registry);
+
+//                                      ●▬▬▬▬   »»»       ecs.cpp       «««  ▬▬▬▬▬●
+
+unsigned int spawn_into(entity_registry &registry, const entity_data &entity)
+{
+    unsigned int components = entity_components(entity.type);
+    unsigned int id = registry.next_id++;
+
+    if (components & STATIC)
+        registry.static_changes++;
+
+    for (size_t i = 0; i < registry.archetypes.size(); i++)
+    {
+        if (registry.archetypes[i].components == components)
+        {
+            add_entity(registry.archetypes[i].entities, entity, id);
+            return id;
+        }
+    }
+
+    archetype_data archetype;
+    archetype.components = components;
+    add_entity(archetype.entities, entity, id);
+    registry.archetypes.push_back(archetype);
+    return id;
+}
+
+size_t total_entities(const entity_registry &registry)
+{
+    size_t result = 0;
+
+    for (size_t i = 0; i < registry.archetypes.size(); i++)
+    {
+        result += entity_count(registry.archetypes[i].entities);
+    }
+    return result;
+}
+
+void remove_dead_entities(entity_registry &registry)
+{
+    for (size_t i = 0; i < registry.archetypes.size(); i++)
+    {
+        size_t before = entity_count(registry.archetypes[i].entities);
+        remove_dead_entities(registry.archetypes[i].entities);
+
+        if ((registry.archetypes[i].components & STATIC) and entity_count(registry.archetypes[i].entities) != before)
+            registry.static_changes++;
+    }
+}
+
+void clear_entities(entity_registry &registry)
+{
+    registry.archetypes.clear();
+    registry.static_changes++;
+}
+
+bool archetype_matches(const archetype_data &archetype, unsigned int with, unsigned int without)
+{
+    return (archetype.components & with) == with and (archetype.components & without) == 0;
+}
+
+/**
+ * Two systems conflict when one writes data the other uses. Archetype data
+ * is only shared when their queries can match the same archetype, the
+ * game's own data is shared whatever they match.
+ */
+bool systems_conflict(const system_data &first, const system_data &second)
+{
+    unsigned int shared = (first.writes & (second.reads | second.writes)) | (second.writes & first.reads);
+    bool disjoint = (first.with & second.without) or (second.with & first.without);
+
+    return (shared & ACCESS_GAME) or ((shared & ~ACCESS_GAME) and not disjoint);
+}
+
+void add_system(scheduler_data &scheduler, const system_data &system)
+{
+    int idx = scheduler.systems.size();
+    size_t stage = 0;
+
+    // the system must run after the last stage holding a system it conflicts with
+    for (size_t s = 0; s < scheduler.stages.size(); s++)
+    {
+        for (size_t i = 0; i < scheduler.stages[s].size(); i++)
+        {
+            if (systems_conflict(scheduler.systems[scheduler.stages[s][i]], system))
+                stage = s + 1;
+        }
+    }
+
+    scheduler.systems.push_back(system);
+
+    if (stage == scheduler.stages.size())
+        scheduler.stages.push_back(vector<int>());
+    scheduler.stages[stage].push_back(idx);
+}
+
+/**
+ * Runs one system over all the archetypes it matches.
+ */
+void run_system(const system_data &system, game_data &game, entity_registry &registry)
+{
+    for (size_t i = 0; i < registry.archetypes.size(); i++)
+    {
+        if (archetype_matches(registry.archetypes[i], system.with, system.without))
+            system.run(game, registry.archetypes[i]);
+    }
+}
+
+void run_systems(const scheduler_data &scheduler, game_data &game, entity_registry &registry)
+{
+    // handing work to the pool costs more than a few hundred entities take to update
+    worker_pool *pool = total_entities(registry) >= ECS_PARALLEL_MIN ? game_pool(game) : nullptr;
+
+    for (size_t s = 0; s < scheduler.stages.size(); s++)
+    {
+        const vector<int> &stage = scheduler.stages[s];
+
+        run_on_pool(pool, stage.size(), [&](size_t i)
+        {
+            run_system(scheduler.systems[stage[i]], game, registry);
+        });
+    }
+}
+
+//                                      ●▬▬▬▬   »»»       spatial.𝗵       «««  ▬▬▬▬▬●
+
+#define SPATIAL_MIN_CELL_SIZE 64
+#define SPATIAL_ENTITIES_PER_CELL 4
+#define SPATIAL_CELLS_PER_ENTITY 2
+
+/**
+ * An entity in the grid. The four values are used together by every
+ * query, so they are kept together.
+ * 
+ * @field   x, y        centre of the entity
+ * @field   radius      half the average of its width and height
+ * @field   ref         the archetype and index of the entity, see spatial_ref
+ */
+struct spatial_entry
+{
+    float x, y;
+    float radius;
+    uint32_t ref;
+};
+
+/**
+ * A uniform grid over the live entities of a registry, rebuilt from scratch
+ * with a counting sort so the entities of a cell sit next to each other.
+ * Every entity is kept in the cell of its centre. Cells are never smaller
+ * than the largest entity, so an entity only reaches into the cells next
+ * to its own. The grid only covers the entities, and the cells are sized
+ * for about SPATIAL_ENTITIES_PER_CELL entities each so a sparse game gets
+ * a few big cells and a crowded one many small ones.
+ * 
+ * @field   min_x, min_y    world position of the top left of the grid
+ * @field   cell_size       width and height of a cell
+ * @field   max_radius      radius of the largest entity in the grid
+ * @field   columns, rows   size of the grid in cells
+ * @field   cell_start      where each cell starts in entries, with one extra at the end
+ * @field   entries         the entities sorted by cell
+ * @field   components      the components of each archetype when the grid was built
+ * @field   in_grid         1 for each entity of each archetype that was put in the grid
+ * @field   unsorted        scratch lists reused by every build so building does not allocate
+ * @field   unsorted_cell   the cell of each unsorted entity
+ */
+struct spatial_index
+{
+    float min_x, min_y;
+    float cell_size;
+    float max_radius;
+    int columns, rows;
+    vector<uint32_t> cell_start;
+    vector<spatial_entry> entries;
+    vector<unsigned int> components;
+    vector<vector<uint8_t>> in_grid;
+    vector<spatial_entry> unsorted;
+    vector<uint32_t> unsorted_cell;
+};
+
+/**
+ * An entity found by a query.
+ * 
+ * @field   ref         the archetype and index of the entity, see spatial_ref
+ * @field   distance    distance from the query point to the entity's centre,
+ *                      or along the ray to where it was hit
+ */
+struct spatial_hit
+{
+    uint32_t ref;
+    float distance;
+};
+
+/**
+ * Packs an archetype index (8 bits) and entity index (24 bits) into one number.
+ * Refs stay valid until entities are removed from the registry.
+ */
+uint32_t spatial_ref(size_t archetype, size_t index);
+size_t ref_archetype(uint32_t ref);
+size_t ref_index(uint32_t ref);
+
+/**
+ * Checks if an entity was put in the grid when it was last built. Entities
+ * added since, sleeping ones and the ones of archetypes it skips are not.
+ * 
+ * @param archetype     index of the entity's archetype in the registry
+ * @param idx           index of the entity in its archetype
+ */
+bool spatial_holds(const spatial_index &index, size_t archetype, size_t idx);
+
+/**
+ * Rebuilds the grid from the live entities of a registry. Sleeping
+ * entities are left out, they are too far away to matter to any query.
+ * 
+ * @param index     the grid to rebuild
+ * @param registry  the entities to put in it
+ * @param with      components an archetype needs to be put in the grid, 0 for any
+ * @param without   components that keep an archetype out of the grid
+ */
+void build_spatial_index(spatial_index &index, const entity_registry &registry, unsigned int with, unsigned int without);
+
+/**
+ * Finds the entities with their centre within a distance of a point.
+ * 
+ * @param x, y      the point
+ * @param range     the distance
+ * @param with      components the entities need, 0 for any entity
+ * @param hits      the entities found are added to the end of this
+ */
+void spatial_in_radius(const spatial_index &index, float x, float y, float range, unsigned int with, vector<spatial_hit> &hits);
+
+/**
+ * Finds the entities with their centre closest to a point, closest first.
+ * 
+ * @param count     how many to find at most
+ * @param with      components the entities need, 0 for any entity
+ * @param hits      replaced with the entities found
+ */
+void spatial_nearest(const spatial_index &index, float x, float y, int count, unsigned int with, vector<spatial_hit> &hits);
+
+/**
+ * Casts a ray, or a segment when max_distance is finite, and finds the
+ * first entity it hits. The cells are walked in order with a DDA.
+ * 
+ * @param x, y          start of the ray
+ * @param dir_x, dir_y  direction of the ray, does not need to be unit length
+ * @param max_distance  how far the ray goes
+ * @param with          components the entities need, 0 for any entity
+ * @param hit           set to the entity that was hit
+ * @return              true if the ray hit an entity
+ */
+bool spatial_raycast(const spatial_index &index, float x, float y, float dir_x, float dir_y, float max_distance, unsigned int with, spatial_hit &hit);
+
+/**
+ * Finds the first entity a short segment runs into. Made for things that
+ * move much less than a cell each update, where setting up a raycast costs
+ * more than just checking the few cells around the segment.
+ * 
+ * @param x, y      start of the segment
+ * @param dx, dy    the segment, from its start to its end
+ * @param with      components the entities need, 0 for any entity
+ * @param hit       set to the entity that was hit
+ * @return          true if the segment hit an entity
+ */
+bool spatial_sweep(const spatial_index &index, float x, float y, float dx, float dy, unsigned int with, spatial_hit &hit);
+
+//                                      ●▬▬▬▬   »»»       spatial.cpp       «««  ▬▬▬▬▬●
+
+uint32_t spatial_ref(size_t archetype, size_t index)
+{
+    return (uint32_t)(archetype << 24 | index);
+}
+
+size_t ref_archetype(uint32_t ref)
+{
+    return ref >> 24;
+}
+
+size_t ref_index(uint32_t ref)
+{
+    return ref & 0xffffff;
+}
+
+bool spatial_holds(const spatial_index &index, size_t archetype, size_t idx)
+{
+    return archetype < index.in_grid.size() and idx < index.in_grid[archetype].size() and index.in_grid[archetype][idx];
+}
+
+/**
+ * the cell of a position along one axis, it can be outside the grid
+ */
+int spatial_cell(float value, float min, float cell_size)
+{
+    return (int)floor((value - min) / cell_size);
+}
+
+void build_spatial_index(spatial_index &index, const entity_registry &registry, unsigned int with, unsigned int without)
+{
+    index.unsorted.resize(total_entities(registry));
+    index.components.clear();
+    index.in_grid.resize(registry.archetypes.size());
+    size_t count = 0;
+
+    float min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY, max_radius = 0;
+
+    for (size_t a = 0; a < registry.archetypes.size(); a++)
+    {
+        const entity_store &entities = registry.archetypes[a].entities;
+        index.components.push_back(registry.archetypes[a].components);
+        index.in_grid[a].assign(entity_count(entities), 0);
+
+        if (not archetype_matches(registry.archetypes[a], with, without))
+            continue;
+
+        for (size_t i = 0; i < entity_count(entities); i++)
+        {
+            if (entities.dead[i] or entities.interval[i] == 0)
+                continue;
+
+            index.in_grid[a][i] = 1;
+
+            float cx = entities.x[i] + entities.width[i] / 2;
+            float cy = entities.y[i] + entities.height[i] / 2;
+            float radius = (entities.width[i] + entities.height[i]) / 4;
+
+            index.unsorted[count++] = {cx, cy, radius, spatial_ref(a, i)};
+
+            min_x = min(min_x, cx);
+            min_y = min(min_y, cy);
+            max_x = max(max_x, cx);
+            max_y = max(max_y, cy);
+            max_radius = max(max_radius, radius);
+        }
+    }
+
+    if (count == 0)
+    {
+        index.columns = index.rows = 0;
+        index.cell_start.assign(1, 0);
+        index.entries.clear();
+        return;
+    }
+
+    index.min_x = min_x;
+    index.min_y = min_y;
+    index.max_radius = max_radius;
+    index.cell_size = max(max_radius, max((float)SPATIAL_MIN_CELL_SIZE, sqrt((max_x - min_x) * (max_y - min_y) * SPATIAL_ENTITIES_PER_CELL / count)));
+
+    // entities along a line have no area, their cells grow until the grid is small enough
+    do
+    {
+        index.columns = spatial_cell(max_x, min_x, index.cell_size) + 1;
+        index.rows = spatial_cell(max_y, min_y, index.cell_size) + 1;
+        if ((double)index.columns * index.rows <= SPATIAL_CELLS_PER_ENTITY * count + 64)
+            break;
+        index.cell_size *= 2;
+    } while (true);
+
+    // counting sort by cell, every entity is right or below the corner so truncating is the same as floor
+    index.cell_start.assign((size_t)index.columns * index.rows + 1, 0);
+    index.unsorted_cell.resize(count);
+    float per_cell = 1 / index.cell_size;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        int cx = min(index.columns - 1, (int)((index.unsorted[i].x - min_x) * per_cell));
+        int cy = min(index.rows - 1, (int)((index.unsorted[i].y - min_y) * per_cell));
+        index.unsorted_cell[i] = cy * index.columns + cx;
+        index.cell_start[index.unsorted_cell[i] + 1]++;
+    }
+
+    for (size_t c = 1; c < index.cell_start.size(); c++)
+    {
+        index.cell_start[c] += index.cell_start[c - 1];
+    }
+
+    index.entries.resize(count);
+
+    // cell_start is used as the write position of each cell, then moved back
+    for (size_t i = 0; i < count; i++)
+    {
+        index.entries[index.cell_start[index.unsorted_cell[i]]++] = index.unsorted[i];
+    }
+
+    for (size_t c = index.cell_start.size() - 1; c > 0; c--)
+    {
+        index.cell_start[c] = index.cell_start[c - 1];
+    }
+    index.cell_start[0] = 0;
+}
+
+/**
+ * checks if an entity in the grid has the components a query wants
+ */
+bool spatial_matches(const spatial_index &index, uint32_t ref, unsigned int with)
+{
+    return (index.components[ref_archetype(ref)] & with) == with;
+}
+
+void spatial_in_radius(const spatial_index &index, float x, float y, float range, unsigned int with, vector<spatial_hit> &hits)
+{
+    if (index.columns == 0)
+        return;
+
+    int first_x = max(0, spatial_cell(x - range, index.min_x, index.cell_size));
+    int first_y = max(0, spatial_cell(y - range, index.min_y, index.cell_size));
+    int last_x = min(index.columns - 1, spatial_cell(x + range, index.min_x, index.cell_size));
+    int last_y = min(index.rows - 1, spatial_cell(y + range, index.min_y, index.cell_size));
+    float range_sq = range * range;
+
+    for (int cy = first_y; cy <= last_y; cy++)
+    {
+        // the cells of a row are next to each other in the sorted lists
+        size_t row = (size_t)cy * index.columns;
+        for (uint32_t i = index.cell_start[row + first_x]; i < index.cell_start[row + last_x + 1]; i++)
+        {
+            const spatial_entry &entry = index.entries[i];
+            float dx = entry.x - x, dy = entry.y - y;
+            float dist_sq = dx * dx + dy * dy;
+
+            if (dist_sq <= range_sq and spatial_matches(index, entry.ref, with))
+                hits.push_back({entry.ref, sqrt(dist_sq)});
+        }
+    }
+}
+
+/**
+ * tests the entities of one cell for spatial_nearest, keeping hits sorted
+ * by squared distance and no longer than count
+ */
+void nearest_in_cell(const spatial_index &index, int cx, int cy, float x, float y, size_t count, unsigned int with, vector<spatial_hit> &hits)
+{
+    size_t cell = (size_t)cy * index.columns + cx;
+
+    for (uint32_t i = index.cell_start[cell]; i < index.cell_start[cell + 1]; i++)
+    {
+        const spatial_entry &entry = index.entries[i];
+        float dx = entry.x - x, dy = entry.y - y;
+        float dist_sq = dx * dx + dy * dy;
+
+        if (hits.size() == count and dist_sq >= hits.back().distance)
+            continue;
+        if (not spatial_matches(index, entry.ref, with))
+            continue;
+
+        if (hits.size() == count)
+            hits.pop_back();
+
+        size_t at = hits.size();
+        hits.push_back({entry.ref, dist_sq});
+        while (at > 0 and hits[at - 1].distance > dist_sq)
+        {
+            hits[at] = hits[at - 1];
+            at--;
+        }
+        hits[at] = {entry.ref, dist_sq};
+    }
+}
+
+void spatial_nearest(const spatial_index &index, float x, float y, int count, unsigned int with, vector<spatial_hit> &hits)
+{
+    hits.clear();
+    if (index.columns == 0 or count <= 0)
+        return;
+
+    int qx = spatial_cell(x, index.min_x, index.cell_size);
+    int qy = spatial_cell(y, index.min_y, index.cell_size);
+
+    // the furthest ring that still touches the grid
+    int last_ring = max(max(qx, index.columns - 1 - qx), max(qy, index.rows - 1 - qy));
+
+    // cells in ring r+1 are at least r cells away, so the search stops once the hits are closer than that
+    for (int ring = 0; ring <= last_ring; ring++)
+    {
+        for (int cy = qy - ring; cy <= qy + ring; cy++)
+        {
+            if (cy < 0 or cy >= index.rows)
+                continue;
+
+            // the top and bottom rows of the ring are whole, the rows between only have their ends
+            bool edge = cy == qy - ring or cy == qy + ring;
+            int step = (edge or ring == 0) ? 1 : 2 * ring;
+
+            for (int cx = qx - ring; cx <= qx + ring; cx += step)
+            {
+                if (cx >= 0 and cx < index.columns)
+                    nearest_in_cell(index, cx, cy, x, y, count, with, hits);
+            }
+        }
+
+        float reach = ring * index.cell_size;
+        if (hits.size() == (size_t)count and hits.back().distance <= reach * reach)
+            break;
+    }
+
+    for (size_t i = 0; i < hits.size(); i++)
+    {
+        hits[i].distance = sqrt(hits[i].distance);
+    }
+}
+
+/**
+ * tests the entities of one cell against a ray, keeping the closest hit
+ */
+void ray_in_cell(const spatial_index &index, int cx, int cy, float x, float y, float ux, float uy, float max_distance, unsigned int with, spatial_hit &best)
+{
+    if (cx < 0 or cy < 0 or cx >= index.columns or cy >= index.rows)
+        return;
+
+    size_t cell = (size_t)cy * index.columns + cx;
+
+    for (uint32_t i = index.cell_start[cell]; i < index.cell_start[cell + 1]; i++)
+    {
+        const spatial_entry &entry = index.entries[i];
+        float mx = entry.x - x, my = entry.y - y;
+        float along = mx * ux + my * uy;
+        float away = mx * uy - my * ux;
+        float away_sq = away * away;
+        float radius_sq = entry.radius * entry.radius;
+
+        if (away_sq > radius_sq)
+            continue;
+
+        // where the ray goes into the circle, 0 if it starts inside
+        float t = max(0.0f, along - sqrt(radius_sq - away_sq));
+        if (t > max_distance or t >= best.distance or along + sqrt(radius_sq - away_sq) < 0)
+            continue;
+        if (not spatial_matches(index, entry.ref, with))
+            continue;
+
+        best = {entry.ref, t};
+    }
+}
+
+bool spatial_sweep(const spatial_index &index, float x, float y, float dx, float dy, unsigned int with, spatial_hit &hit)
+{
+    if (index.columns == 0)
+        return false;
+
+    // only entities with their centre within max_radius of the segment's box can be hit,
+    // which with cells this big is usually the one cell the segment is in
+    float reach = index.max_radius;
+    int left = max(0, spatial_cell(min(x, x + dx) - reach, index.min_x, index.cell_size));
+    int right = min(index.columns - 1, spatial_cell(max(x, x + dx) + reach, index.min_x, index.cell_size));
+    int top = max(0, spatial_cell(min(y, y + dy) - reach, index.min_y, index.cell_size));
+    int bottom = min(index.rows - 1, spatial_cell(max(y, y + dy) + reach, index.min_y, index.cell_size));
+
+    if (left > right or top > bottom)
+        return false;
+
+    float length = sqrt(dx * dx + dy * dy);
+    if (length == 0)
+        return false;
+
+    spatial_hit best = {0, INFINITY};
+    for (int cy = top; cy <= bottom; cy++)
+    {
+        for (int cx = left; cx <= right; cx++)
+        {
+            ray_in_cell(index, cx, cy, x, y, dx / length, dy / length, length, with, best);
+        }
+    }
+
+    if (best.distance == INFINITY)
+        return false;
+
+    hit = best;
+    return true;
+}
+
+bool spatial_raycast(const spatial_index &index, float x, float y, float dir_x, float dir_y, float max_distance, unsigned int with, spatial_hit &hit)
+{
+    float length = sqrt(dir_x * dir_x + dir_y * dir_y);
+    if (index.columns == 0 or length == 0)
+        return false;
+
+    float ux = dir_x / length, uy = dir_y / length;
+    float cell = index.cell_size;
+
+    // clip the ray to the grid plus the ring of cells around it
+    float left = index.min_x - cell, right = index.min_x + (index.columns + 1) * cell;
+    float top = index.min_y - cell, bottom = index.min_y + (index.rows + 1) * cell;
+    float t_enter = 0, t_exit = max_distance;
+
+    if (ux != 0)
+    {
+        float t1 = (left - x) / ux, t2 = (right - x) / ux;
+        t_enter = max(t_enter, min(t1, t2));
+        t_exit = min(t_exit, max(t1, t2));
+    }
+    else if (x < left or x > right)
+        return false;
+
+    if (uy != 0)
+    {
+        float t1 = (top - y) / uy, t2 = (bottom - y) / uy;
+        t_enter = max(t_enter, min(t1, t2));
+        t_exit = min(t_exit, max(t1, t2));
+    }
+    else if (y < top or y > bottom)
+        return false;
+
+    if (t_enter > t_exit)
+        return false;
+
+    // amanatides and woo: the distance along the ray to the next cell edge on each axis
+    float start_x = x + ux * t_enter, start_y = y + uy * t_enter;
+    int cx = spatial_cell(start_x, index.min_x, cell);
+    int cy = spatial_cell(start_y, index.min_y, cell);
+    int step_x = ux > 0 ? 1 : -1, step_y = uy > 0 ? 1 : -1;
+
+    float next_x = ux != 0 ? t_enter + ((index.min_x + (cx + (ux > 0)) * cell) - start_x) / ux : INFINITY;
+    float next_y = uy != 0 ? t_enter + ((index.min_y + (cy + (uy > 0)) * cell) - start_y) / uy : INFINITY;
+    float delta_x = ux != 0 ? cell / fabs(ux) : INFINITY;
+    float delta_y = uy != 0 ? cell / fabs(uy) : INFINITY;
+
+    spatial_hit best = {0, INFINITY};
+
+    // entities reach one cell past their own, so the first cell checks its neighbours too
+    for (int ny = cy - 1; ny <= cy + 1; ny++)
+    {
+        for (int nx = cx - 1; nx <= cx + 1; nx++)
+        {
+            ray_in_cell(index, nx, ny, x, y, ux, uy, max_distance, with, best);
+        }
+    }
+
+    float t = t_enter;
+    while (t <= t_exit and t <= best.distance)
+    {
+        // each step only adds the row or column of neighbours the last cell did not have
+        if (next_x < next_y)
+        {
+            t = next_x;
+            next_x += delta_x;
+            cx += step_x;
+            for (int ny = cy - 1; ny <= cy + 1; ny++)
+            {
+                ray_in_cell(index, cx + step_x, ny, x, y, ux, uy, max_distance, with, best);
+            }
+        }
+        else
+        {
+            t = next_y;
+            next_y += delta_y;
+            cy += step_y;
+            for (int nx = cx - 1; nx <= cx + 1; nx++)
+            {
+                ray_in_cell(index, nx, cy + step_y, x, y, ux, uy, max_distance, with, best);
+            }
+        }
+    }
+
+    if (best.distance == INFINITY)
+        return false;
+
+    hit = best;
+    return true;
+}
+
+/**
+ * Times building the grid and the queries over a number of entities
+ * spread out like a busy game (one per 100 by 100 pixels).
+ */
+void run_spatial_benchmark(int count)
+{
+    const int queries = 100000;
+    float side = sqrt((float)count) * 100;
+
+    entity_registry registry;
+    registry.next_id = 1;
+    registry.static_changes = 0;
+    game_rng rng = new_rng(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        spawn_into(registry, entity_spawn(rng_float(rng) * side, rng_float(rng) * side, rng));
+    }
+
+    spatial_index index;
+    auto start = chrono::steady_clock::now();
+    const int builds = 5;
+    for (int b = 0; b < builds; b++)
+    {
+        build_spatial_index(index, registry, 0, 0);
+    }
+    double build_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / builds;
+
+    vector<float> points(queries * 2);
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        points[i] = rng_float(rng) * side;
+    }
+
+    vector<spatial_hit> hits;
+    size_t found = 0;
+
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++)
+    {
+        hits.clear();
+        spatial_in_radius(index, points[2 * q], points[2 * q + 1], 200, 0, hits);
+        found += hits.size();
+    }
+    double radius_ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / queries;
+
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++)
+    {
+        spatial_nearest(index, points[2 * q], points[2 * q + 1], 8, 0, hits);
+        found += hits.size();
+    }
+    double nearest_ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / queries;
+
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++)
+    {
+        spatial_hit hit;
+        float angle = points[q] / side * 6.2832f;
+        found += spatial_raycast(index, points[2 * q], points[2 * q + 1], cos(angle), sin(angle), 1000, 0, hit);
+    }
+    double ray_ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / queries;
+
+    write_line(to_string(count) + " entities: build " + to_string(build_ms) + " ms, radius 200 " + to_string((int)radius_ns) + " ns, nearest 8 " + to_string((int)nearest_ns) + " ns, ray 1000 " + to_string((int)ray_ns) + " ns (" + to_string(found) + " found)");
+}
+
+/**
+ * the first entity a ray hits, found by testing every entity the way ray_in_cell does
+ */
+spatial_hit brute_raycast(const vector<spatial_entry> &all, const entity_registry &registry, float x, float y, float ux, float uy, float max_distance, unsigned int with)
+{
+    spatial_hit best = {0, INFINITY};
+
+    for (size_t i = 0; i < all.size(); i++)
+    {
+        float mx = all[i].x - x, my = all[i].y - y;
+        float along = mx * ux + my * uy;
+        float away = mx * uy - my * ux;
+        float radius_sq = all[i].radius * all[i].radius;
+
+        if (away * away > radius_sq or (registry.archetypes[ref_archetype(all[i].ref)].components & with) != with)
+            continue;
+
+        float t = max(0.0f, along - sqrt(radius_sq - away * away));
+        if (t <= max_distance and t < best.distance and along + sqrt(radius_sq - away * away) >= 0)
+            best = {all[i].ref, t};
+    }
+    return best;
+}
+
+/**
+ * Checks the three queries against going through every entity, on 20
+ * random worlds that are either crowded or sparse, with some entities dead
+ * or asleep so the grid has to leave them out.
+ * 
+ * @return  false if a query found something else, after writing what
+ */
+bool check_spatial_queries()
+{
+    const int worlds = 20;
+    const int queries = 300;
+
+    for (int w = 0; w < worlds; w++)
+    {
+        // even worlds are as crowded as a swarm, odd ones as empty as deep space
+        int count = 200 + 100 * w;
+        float side = sqrt((float)count) * (w % 2 == 0 ? 20 : 500);
+        game_rng rng = new_rng(w + 1);
+
+        entity_registry registry;
+        registry.next_id = 1;
+        registry.static_changes = 0;
+
+        for (int i = 0; i < count; i++)
+        {
+            spawn_into(registry, entity_spawn(rng_float(rng) * side, rng_float(rng) * side, rng));
+        }
+
+        // what the grid should hold, with the centres and sizes it uses
+        vector<spatial_entry> all;
+        for (size_t a = 0; a < registry.archetypes.size(); a++)
+        {
+            entity_store &entities = registry.archetypes[a].entities;
+            for (size_t i = 0; i < entity_count(entities); i++)
+            {
+                int fate = rng_int(rng, 0, 10);
+                if (fate == 0)
+                    entities.dead[i] = 1;
+                else if (fate == 1)
+                    entities.interval[i] = 0;
+                else
+                    all.push_back({entities.x[i] + entities.width[i] / 2, entities.y[i] + entities.height[i] / 2, (entities.width[i] + entities.height[i]) / 4, spatial_ref(a, i)});
+            }
+        }
+
+        spatial_index index;
+        build_spatial_index(index, registry, 0, 0);
+
+        vector<spatial_hit> hits;
+        vector<uint32_t> found, expected;
+        vector<float> distances;
+
+        for (int q = 0; q < queries; q++)
+        {
+            // some queries start outside the grid
+            float x = (rng_float(rng) * 1.4f - 0.2f) * side;
+            float y = (rng_float(rng) * 1.4f - 0.2f) * side;
+            unsigned int with = q % 3 == 0 ? PICKUP : 0;
+            string where = " in world " + to_string(w) + ", query " + to_string(q);
+
+            float range = rng_float(rng) * side * 0.3f;
+            hits.clear();
+            spatial_in_radius(index, x, y, range, with, hits);
+
+            found.clear();
+            expected.clear();
+            distances.clear();
+            for (size_t i = 0; i < hits.size(); i++)
+            {
+                found.push_back(hits[i].ref);
+            }
+            for (size_t i = 0; i < all.size(); i++)
+            {
+                float dx = all[i].x - x, dy = all[i].y - y;
+                if ((registry.archetypes[ref_archetype(all[i].ref)].components & with) != with)
+                    continue;
+                if (dx * dx + dy * dy <= range * range)
+                    expected.push_back(all[i].ref);
+                distances.push_back(sqrt(dx * dx + dy * dy));
+            }
+            sort(found.begin(), found.end());
+            sort(expected.begin(), expected.end());
+
+            if (found != expected)
+            {
+                write_line("radius query found " + to_string(found.size()) + " entities instead of " + to_string(expected.size()) + where);
+                return false;
+            }
+
+            // ties can come back in any order, so only the distances are compared
+            int nearest = 1 + q % 12;
+            spatial_nearest(index, x, y, nearest, with, hits);
+            sort(distances.begin(), distances.end());
+            distances.resize(min(distances.size(), (size_t)nearest));
+
+            bool same = hits.size() == distances.size();
+            for (size_t i = 0; same and i < hits.size(); i++)
+            {
+                same = fabs(hits[i].distance - distances[i]) <= 0.001f * max(1.0f, distances[i]);
+            }
+            if (not same)
+            {
+                write_line("nearest " + to_string(nearest) + " query found " + to_string(hits.size()) + " entities that are not the closest" + where);
+                return false;
+            }
+
+            // half the rays are segments, a few are cast from far outside the grid
+            float angle = rng_float(rng) * 6.2832f;
+            float max_distance = q % 2 == 0 ? INFINITY : rng_float(rng) * side;
+            if (q % 10 == 0)
+            {
+                x -= cos(angle) * side;
+                y -= sin(angle) * side;
+            }
+
+            // the direction does not have to be unit length, the brute force gets it the way the raycast makes it
+            float dir_x = cos(angle) * 3, dir_y = sin(angle) * 3;
+            float length = sqrt(dir_x * dir_x + dir_y * dir_y);
+
+            spatial_hit hit = {0, INFINITY};
+            bool hit_any = spatial_raycast(index, x, y, dir_x, dir_y, max_distance, with, hit);
+            spatial_hit best = brute_raycast(all, registry, x, y, dir_x / length, dir_y / length, max_distance, with);
+
+            if (hit_any != (best.distance != INFINITY) or (hit_any and fabs(hit.distance - best.distance) > 0.001f * max(1.0f, best.distance)))
+            {
+                write_line("raycast hit at " + to_string(hit_any ? hit.distance : -1) + " instead of " + to_string(best.distance != INFINITY ? best.distance : -1) + where);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+//                                      ●▬▬▬▬   »»»       projectile.𝗵       «««  ▬▬▬▬▬●
+
+#define PROJECTILE_POOL_SIZE 256
+#define PROJECTILE_WRECKS_MAX 256
+#define PROJECTILE_BENCH_FOES 2000
+#define PROJECTILE_BENCH_TICKS 600
+#define PROJECTILE_BENCH_EMITTERS 16
+
+/**
+ * The different things the player can shoot.
+ */
+enum projectile_kind : uint8_t
+{
+    BULLET,
+    BOMB,
+    PROJECTILE_KIND_COUNT
+};
+
+/**
+ * Everything that makes one kind of projectile different from the others.
+ * 
+ * @field   bitmap_name     name of the projectile's bitmap in the resource bundle
+ * @field   size            width the bitmap is drawn at, the pictures are much bigger
+ * @field   speed           distance it flies every update
+ * @field   lifetime        updates it flies for before it is gone
+ * @field   blast           radius of the explosion when it goes off, 0 if it only hits what it touches
+ * @field   cooldown        updates the player has to wait before shooting another one
+ */
+struct projectile_archetype
+{
+    const char *bitmap_name;
+    float size;
+    float speed;
+    int lifetime;
+    float blast;
+    int cooldown;
+};
+
+/**
+ * One row per kind of projectile, in the same order as projectile_kind.
+ * Bombs go off when they hit a foe or when they run out.
+ */
+constexpr projectile_archetype PROJECTILE_ARCHETYPES[] = {
+    // bitmap   size    speed   lifetime    blast   cooldown
+    {"bullet",  12,     14,     60,         0,      6},
+    {"bomb",    36,     6,      120,        180,    90},
+};
+
+static_assert(sizeof(PROJECTILE_ARCHETYPES) / sizeof(PROJECTILE_ARCHETYPES[0]) == PROJECTILE_KIND_COUNT, "every projectile kind needs exactly one archetype row");
+
+/**
+ * The projectile pool keeps every projectile in flight in fixed arrays used
+ * as a ring: new projectiles go after the newest one, and once the ring is
+ * full the oldest one makes way. Projectiles that hit something leave a gap
+ * that is skipped until the oldest end of the ring passes it. Nothing is
+ * allocated after the pool is made.
+ * 
+ * @field   x, y            positions of the projectiles
+ * @field   dx, dy          velocities of the projectiles
+ * @field   ticks_left      updates each projectile still flies for
+ * @field   kind            the kind of each projectile
+ * @field   alive           false for the gaps left by projectiles that are gone
+ * @field   head            slot of the oldest projectile
+ * @field   count           number of slots in use from head on, gaps included
+ * @field   live            number of projectiles in flight
+ * @field   mask            capacity - 1, the capacity is a power of two
+ * @field   blast           reused list of the foes caught in an explosion
+ * @field   wrecks          centres of the foes destroyed during the last update, at most PROJECTILE_WRECKS_MAX
+ */
+struct projectile_pool
+{
+    vector<float> x, y;
+    vector<float> dx, dy;
+    vector<uint16_t> ticks_left;
+    vector<projectile_kind> kind;
+    vector<uint8_t> alive;
+    size_t head, count, live, mask;
+    vector<spatial_hit> blast;
+    vector<point_2d> wrecks;
+};
+
+/**
+ * Makes an empty pool.
+ * 
+ * @param capacity  most projectiles in flight at once, rounded up to a power of two
+ */
+projectile_pool new_projectile_pool(size_t capacity);
+
+/**
+ * Shoots a projectile, replacing the oldest one when the pool is full.
+ * 
+ * @param pool          the pool the projectile is added to
+ * @param kind          the kind of projectile
+ * @param x, y          where it starts
+ * @param dir_x, dir_y  direction it flies in, does not need to be unit length
+ */
+void fire_projectile(projectile_pool &pool, projectile_kind kind, float x, float y, float dir_x, float dir_y);
+
+/**
+ * Moves every projectile one update along. Each one sweeps the segment it
+ * moves along through the grid, so fast projectiles can not jump over a foe.
+ * Foes that are hit or caught in a blast are marked dead in the registry
+ * and their centres are kept in the pool's wrecks until the next update.
+ * 
+ * @param pool      the projectiles
+ * @param index     grid of the entities that can be hit, built from the registry
+ * @param registry  the entities the grid was built from
+ * @return          the number of foes destroyed
+ */
+int update_projectiles(projectile_pool &pool, const spatial_index &index, entity_registry &registry);
+
+/**
+ * Makes the bitmap of every projectile kind once, after the resources are
+ * loaded. Each picture is shrunk to the size it is drawn at, so drawing a
+ * projectile does not squeeze the whole picture every frame.
+ */
+void load_projectile_bitmaps();
+
+/**
+ * Draws the projectiles inside a view to the screen.
+ * 
+ * @param pool  the projectiles to draw
+ * @param view  the part of the world on the screen
+ * @param zoom  how big the world is drawn
+ * @param frame the frame being recorded
+ */
+void draw_projectiles(const projectile_pool &pool, const rectangle &view, float zoom, render_list &frame);
+
+/**
+ * Keeps count projectiles in flight, shot in spirals from emitters spread
+ * among PROJECTILE_BENCH_FOES foes, and times the updates against the 60 Hz
+ * frame budget. Also checks that nothing was allocated while it ran.
+ * 
+ * @param count     projectiles kept in flight
+ */
+void run_projectile_benchmark(int count);
+
+//                                      ●▬▬▬▬   »»»       projectile.cpp       «««  ▬▬▬▬▬●
+
+// the bitmap of each projectile kind at the size it is drawn, made by load_projectile_bitmaps
+bitmap projectile_bitmaps[PROJECTILE_KIND_COUNT];
+
+projectile_pool new_projectile_pool(size_t capacity)
+{
+    size_t size = 1;
+    while (size < capacity)
+        size *= 2;
+
+    projectile_pool result;
+    result.x.assign(size, 0);
+    result.y.assign(size, 0);
+    result.dx.assign(size, 0);
+    result.dy.assign(size, 0);
+    result.ticks_left.assign(size, 0);
+    result.kind.assign(size, BULLET);
+    result.alive.assign(size, false);
+    result.head = 0;
+    result.count = 0;
+    result.live = 0;
+    result.mask = size - 1;
+    result.blast.reserve(64);
+    result.wrecks.reserve(PROJECTILE_WRECKS_MAX);
+    return result;
+}
+
+void fire_projectile(projectile_pool &pool, projectile_kind kind, float x, float y, float dir_x, float dir_y)
+{
+    float length = sqrt(dir_x * dir_x + dir_y * dir_y);
+    if (length == 0)
+        return;
+
+    // a full ring drops its oldest projectile
+    if (pool.count == pool.mask + 1)
+    {
+        pool.live -= pool.alive[pool.head];
+        pool.head = (pool.head + 1) & pool.mask;
+        pool.count--;
+    }
+
+    const projectile_archetype &archetype = PROJECTILE_ARCHETYPES[kind];
+    size_t slot = (pool.head + pool.count) & pool.mask;
+
+    pool.x[slot] = x;
+    pool.y[slot] = y;
+    pool.dx[slot] = dir_x / length * archetype.speed;
+    pool.dy[slot] = dir_y / length * archetype.speed;
+    pool.ticks_left[slot] = archetype.lifetime;
+    pool.kind[slot] = kind;
+    pool.alive[slot] = true;
+    pool.count++;
+    pool.live++;
+}
+
+/**
+ * marks a foe dead, unless something else got it first this update
+ * 
+ * @return  1 if the foe was destroyed now, 0 if it already was
+ */
+int destroy_foe(projectile_pool &pool, entity_registry &registry, uint32_t ref)
+{
+    entity_store &entities = registry.archetypes[ref_archetype(ref)].entities;
+    size_t num = ref_index(ref);
+    if (entities.dead[num])
+        return 0;
+
+    entities.dead[num] = true;
+
+    // the wrecks are only for the explosions, past the cap they would not be seen apart anyway
+    if (pool.wrecks.size() < PROJECTILE_WRECKS_MAX)
+        pool.wrecks.push_back(point_at(entities.x[num] + entities.width[num] / 2, entities.y[num] + entities.height[num] / 2));
+    return 1;
+}
+
+/**
+ * destroys every foe within the blast of a projectile going off
+ */
+int explode_projectile(projectile_pool &pool, size_t slot, const spatial_index &index, entity_registry &registry)
+{
+    pool.blast.clear();
+    spatial_in_radius(index, pool.x[slot], pool.y[slot], PROJECTILE_ARCHETYPES[pool.kind[slot]].blast, HOSTILE, pool.blast);
+
+    int destroyed = 0;
+    for (size_t i = 0; i < pool.blast.size(); i++)
+    {
+        destroyed += destroy_foe(pool, registry, pool.blast[i].ref);
+    }
+    return destroyed;
+}
+
+int update_projectiles(projectile_pool &pool, const spatial_index &index, entity_registry &registry)
+{
+    int destroyed = 0;
+    pool.wrecks.clear();
+
+    for (size_t n = 0; n < pool.count; n++)
+    {
+        size_t slot = (pool.head + n) & pool.mask;
+        if (not pool.alive[slot])
+            continue;
+
+        const projectile_archetype &archetype = PROJECTILE_ARCHETYPES[pool.kind[slot]];
+        spatial_hit hit;
+
+        if (spatial_sweep(index, pool.x[slot], pool.y[slot], pool.dx[slot], pool.dy[slot], HOSTILE, hit))
+        {
+            // it stops where it went into the foe, which is where a bomb goes off
+            pool.x[slot] += pool.dx[slot] / archetype.speed * hit.distance;
+            pool.y[slot] += pool.dy[slot] / archetype.speed * hit.distance;
+            destroyed += destroy_foe(pool, registry, hit.ref);
+            if (archetype.blast > 0)
+                destroyed += explode_projectile(pool, slot, index, registry);
+            pool.alive[slot] = false;
+            pool.live--;
+            continue;
+        }
+
+        pool.x[slot] += pool.dx[slot];
+        pool.y[slot] += pool.dy[slot];
+
+        if (--pool.ticks_left[slot] > 0)
+            continue;
+
+        if (archetype.blast > 0)
+            destroyed += explode_projectile(pool, slot, index, registry);
+        pool.alive[slot] = false;
+        pool.live--;
+    }
+
+    // the gaps at the old end of the ring are given back
+    while (pool.count > 0 and not pool.alive[pool.head])
+    {
+        pool.head = (pool.head + 1) & pool.mask;
+        pool.count--;
+    }
+
+    return destroyed;
+}
+
+void load_projectile_bitmaps()
+{
+    for (int i = 0; i < PROJECTILE_KIND_COUNT; i++)
+    {
+        bitmap source = bitmap_named(PROJECTILE_ARCHETYPES[i].bitmap_name);
+        int width = bitmap_width(source), height = bitmap_height(source);
+        double scale = PROJECTILE_ARCHETYPES[i].size / width;
+
+        int small_width = (int)ceil(width * scale), small_height = (int)ceil(height * scale);
+        bitmap small = create_bitmap(string("projectile_") + PROJECTILE_ARCHETYPES[i].bitmap_name, small_width, small_height);
+        live_resources.bitmaps++;
+
+        // bitmaps are scaled around their centre, so the picture is drawn up and left by what it loses
+        clear_bitmap(small, COLOR_TRANSPARENT);
+        draw_bitmap_on_bitmap(small, source, -(width - small_width) / 2.0, -(height - small_height) / 2.0, option_scale_bmp(scale, scale));
+        projectile_bitmaps[i] = small;
+    }
+}
+
+void draw_projectiles(const projectile_pool &pool, const rectangle &view, float zoom, render_list &frame)
+{
+    for (size_t n = 0; n < pool.count; n++)
+    {
+        size_t slot = (pool.head + n) & pool.mask;
+        if (not pool.alive[slot] or pool.x[slot] < view.x or pool.y[slot] < view.y or pool.x[slot] > view.x + view.width or pool.y[slot] > view.y + view.height)
+            continue;
+
+        // bitmaps are scaled around their centre, so the centre is put on the projectile
+        bitmap image = projectile_bitmaps[pool.kind[slot]];
+        float sx = (pool.x[slot] - view.x) * zoom, sy = (pool.y[slot] - view.y) * zoom;
+        record_bitmap(frame, LAYER_PROJECTILES, image, sx - bitmap_width(image) / 2.0f, sy - bitmap_height(image) / 2.0f, zoom);
+    }
+}
+
+void run_projectile_benchmark(int count)
+{
+    const float side = 24000;
+
+    entity_registry registry;
+    registry.next_id = 1;
+    registry.static_changes = 0;
+    game_rng rng = new_rng(count);
+
+    for (int i = 0; i < PROJECTILE_BENCH_FOES; i++)
+    {
+        spawn_into(registry, entity_spawn(FOE, rng_float(rng) * side, rng_float(rng) * side, rng));
+    }
+
+    spatial_index index;
+    build_spatial_index(index, registry, 0, 0);
+
+    // the pool is topped back up every update, but fills over a few updates at the start
+    projectile_pool pool = new_projectile_pool(count);
+    const int per_tick = 2 * (count + PROJECTILE_ARCHETYPES[BULLET].lifetime - 1) / PROJECTILE_ARCHETYPES[BULLET].lifetime;
+    const float *first_slot = pool.x.data();
+    size_t blast_capacity = pool.blast.capacity();
+    size_t wrecks_capacity = pool.wrecks.capacity();
+
+    double total_ms = 0, worst_ms = 0;
+    long destroyed = 0;
+    size_t in_flight = 0;
+
+    for (int tick = 0; tick < PROJECTILE_BENCH_TICKS; tick++)
+    {
+        auto start = chrono::steady_clock::now();
+
+        int shots = min(per_tick, count - (int)pool.live);
+        for (int i = 0; i < shots; i++)
+        {
+            // every emitter turns a little each update, which makes the spiral
+            int emitter = i % PROJECTILE_BENCH_EMITTERS;
+            float angle = tick * 0.05f + i * 6.2832f / shots;
+            float ex = side * (emitter % 4 + 0.5f) / 4, ey = side * (emitter / 4 + 0.5f) / 4;
+            fire_projectile(pool, tick % 30 == 0 and i == 0 ? BOMB : BULLET, ex, ey, cos(angle), sin(angle));
+        }
+        destroyed += update_projectiles(pool, index, registry);
+
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        total_ms += ms;
+        worst_ms = max(worst_ms, ms);
+
+        // the foes come straight back so there is always something to hit
+        for (size_t a = 0; a < registry.archetypes.size(); a++)
+        {
+            fill(registry.archetypes[a].entities.dead.begin(), registry.archetypes[a].entities.dead.end(), 0);
+        }
+
+        if (tick == PROJECTILE_BENCH_TICKS / 2)
+            in_flight = pool.live;
+    }
+
+    bool allocated = pool.x.data() != first_slot or pool.blast.capacity() != blast_capacity or pool.wrecks.capacity() != wrecks_capacity;
+    double budget_ms = 1000.0 / 60;
+
+    write_line(to_string(in_flight) + " projectiles in flight: " + to_string(total_ms / PROJECTILE_BENCH_TICKS) + " ms per update, worst " + to_string(worst_ms) + " ms, " + to_string(destroyed) + " hits");
+    write_line(string(worst_ms <= budget_ms ? "holds" : "misses") + " 60 Hz, " + (allocated ? "the pool allocated while running" : "no allocations while running"));
+}
+
+//                                      ●▬▬▬▬   »»»       particles.𝗵       «««  ▬▬▬▬▬●
+
+#define PARTICLE_CAPACITY 131072
+#define PARTICLE_CELL 4
+#define PARTICLE_CELL_ALPHA 0.35f
+#define PARTICLE_DRAG 0.96f
+#define PARTICLE_BENCH_FRAMES 600
+
+/**
+ * The different bursts of particles.
+ */
+enum particle_effect : uint8_t
+{
+    EXPLOSION,
+    POWER_UP_SPARKLE,
+    ALLY_SPARKLE,
+    PARTICLE_EFFECT_COUNT
+};
+
+/**
+ * Everything that makes one burst of particles different from the others.
+ * 
+ * @field   tint        colour of the particles
+ * @field   count       particles in one burst
+ * @field   speed       fastest a particle leaves the burst at
+ * @field   lifetime    updates a particle lasts, it fades out over them
+ */
+struct particle_effect_data
+{
+    color tint;
+    int count;
+    float speed;
+    float lifetime;
+};
+
+constexpr color EXPLOSION_TINT = {1.0f, 0.55f, 0.1f, 1.0f};
+
+/**
+ * One row per effect, in the same order as particle_effect.
+ * The sparkles use the colours the minimap shows power ups and allies in.
+ */
+constexpr particle_effect_data PARTICLE_EFFECTS[] = {
+    // tint             count   speed   lifetime
+    {EXPLOSION_TINT,    160,    5,      45},
+    {MINIMAP_POWER_UP,  60,     3,      30},
+    {MINIMAP_ALLY,      90,     3,      40},
+};
+
+static_assert(sizeof(PARTICLE_EFFECTS) / sizeof(PARTICLE_EFFECTS[0]) == PARTICLE_EFFECT_COUNT, "every particle effect needs exactly one row");
+
+/**
+ * The particles drawn this frame, added up on a grid of PARTICLE_CELL pixel
+ * cells over the screen. Each covered cell is drawn as one rectangle, so the
+ * number of draw calls depends on the screen and not on the particles.
+ * 
+ * @field   columns, rows   size of the grid in cells
+ * @field   red, green, blue    the tints of the particles in each cell added up
+ * @field   weight          how much particle each cell has, faded ones count less
+ * @field   covered         the cells with any particles, in the order they were found
+ */
+struct particle_batch
+{
+    int columns, rows;
+    vector<float> red, green, blue;
+    vector<float> weight;
+    vector<uint32_t> covered;
+};
+
+/**
+ * The particle system keeps every live particle as separate arrays so the
+ * update runs over them with SIMD. Dead particles are squeezed out after
+ * each update, and the arrays never grow past the capacity they were made with.
+ * 
+ * @field   x, y        positions of the particles
+ * @field   dx, dy      velocities of the particles
+ * @field   life        updates each particle has left
+ * @field   effect      the effect each particle came from
+ * @field   count       number of live particles, they are the first count of each array
+ * @field   rng         random numbers of the bursts, separate so effects never change a game
+ * @field   batch       reused by every draw
+ */
+struct particle_system
+{
+    vector<float> x, y;
+    vector<float> dx, dy;
+    vector<float> life;
+    vector<particle_effect> effect;
+    size_t count;
+    game_rng rng;
+    particle_batch batch;
+};
+
+/**
+ * Makes an empty particle system.
+ * 
+ * @param capacity  most particles alive at once, 0 for a system that ignores every burst
+ */
+particle_system new_particle_system(size_t capacity);
+
+/**
+ * Adds a burst of particles, as many as still fit.
+ * 
+ * @param system    the particle system
+ * @param effect    the kind of burst
+ * @param x, y      centre of the burst
+ */
+void emit_particles(particle_system &system, particle_effect effect, float x, float y);
+
+/**
+ * Moves, slows and ages every particle, then removes the ones that ran out.
+ * 
+ * @param system    the particle system
+ */
+void update_particles(particle_system &system);
+
+/**
+ * Adds up the particles inside a view into the system's batch.
+ * 
+ * @param system    the particle system
+ * @param view      the part of the world on the screen
+ */
+void batch_particles(particle_system &system, const rectangle &view);
+
+/**
+ * Draws the particles inside a view, one rectangle for every covered cell.
+ * 
+ * @param system    the particle system
+ * @param view      the part of the world on the screen
+ * @param frame     the frame being recorded
+ */
+void draw_particles(particle_system &system, const rectangle &view, render_list &frame);
+
+/**
+ * Keeps count particles alive with bursts all over the screen and times
+ * the updates and batching against the 60 Hz frame budget.
+ * 
+ * @param count     particles kept alive
+ */
+void run_particle_benchmark(int count);
+
+//                                      ●▬▬▬▬   »»»       particles.cpp       «««  ▬▬▬▬▬●
+
+particle_system new_particle_system(size_t capacity)
+{
+    particle_system result;
+    result.x.resize(capacity);
+    result.y.resize(capacity);
+    result.dx.resize(capacity);
+    result.dy.resize(capacity);
+    result.life.resize(capacity);
+    result.effect.resize(capacity);
+    result.count = 0;
+    result.rng = new_rng(capacity);
+
+    particle_batch &batch = result.batch;
+    batch.columns = batch.rows = 0;
+    if (capacity == 0)
+        return result;
+
+    batch.columns = WINDOW_WIDTH / PARTICLE_CELL + 1;
+    batch.rows = WINDOW_HEIGHT / PARTICLE_CELL + 1;
+    batch.red.assign(batch.columns * batch.rows, 0);
+    batch.green.assign(batch.columns * batch.rows, 0);
+    batch.blue.assign(batch.columns * batch.rows, 0);
+    batch.weight.assign(batch.columns * batch.rows, 0);
+    batch.covered.reserve(batch.columns * batch.rows);
+    return result;
+}
+
+void emit_particles(particle_system &system, particle_effect effect, float x, float y)
+{
+    const particle_effect_data &data = PARTICLE_EFFECTS[effect];
+    size_t room = system.x.size() - system.count;
+    size_t count = min((size_t)data.count, room);
+
+    for (size_t n = 0; n < count; n++)
+    {
+        size_t i = system.count++;
+        float angle = rng_float(system.rng) * 6.2832f;
+        float speed = data.speed * (0.2f + 0.8f * rng_float(system.rng));
+
+        system.x[i] = x;
+        system.y[i] = y;
+        system.dx[i] = cos(angle) * speed;
+        system.dy[i] = sin(angle) * speed;
+
+        // they do not all go out at once
+        system.life[i] = data.lifetime * (0.5f + 0.5f * rng_float(system.rng));
+        system.effect[i] = effect;
+    }
+}
+
+/**
+ * Moves each particle by its velocity, slows it down by the drag and takes
+ * one update off its life, eight at a time with AVX or four at a time with SSE,
+ * finishing the rest one by one.
+ */
+void integrate_particles(float *x, float *y, float *dx, float *dy, float *life, size_t count)
+{
+    size_t i = 0;
+
+#if defined(__AVX__)
+    __m256 drag8 = _mm256_set1_ps(PARTICLE_DRAG), one8 = _mm256_set1_ps(1);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(dx + i), vy = _mm256_loadu_ps(dy + i);
+        _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_loadu_ps(x + i), vx));
+        _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), vy));
+        _mm256_storeu_ps(dx + i, _mm256_mul_ps(vx, drag8));
+        _mm256_storeu_ps(dy + i, _mm256_mul_ps(vy, drag8));
+        _mm256_storeu_ps(life + i, _mm256_sub_ps(_mm256_loadu_ps(life + i), one8));
+    }
+#endif
+#if defined(__SSE2__)
+    __m128 drag4 = _mm_set1_ps(PARTICLE_DRAG), one4 = _mm_set1_ps(1);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(dx + i), vy = _mm_loadu_ps(dy + i);
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), vx));
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), vy));
+        _mm_storeu_ps(dx + i, _mm_mul_ps(vx, drag4));
+        _mm_storeu_ps(dy + i, _mm_mul_ps(vy, drag4));
+        _mm_storeu_ps(life + i, _mm_sub_ps(_mm_loadu_ps(life + i), one4));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        x[i] += dx[i];
+        y[i] += dy[i];
+        dx[i] *= PARTICLE_DRAG;
+        dy[i] *= PARTICLE_DRAG;
+        life[i] -= 1;
+    }
+}
+
+void update_particles(particle_system &system)
+{
+    integrate_particles(system.x.data(), system.y.data(), system.dx.data(), system.dy.data(), system.life.data(), system.count);
+
+    // the live particles are moved down over the dead ones. every particle is
+    // copied and only the live ones move the write position on, so nothing branches
+    size_t kept = 0;
+    for (size_t i = 0; i < system.count; i++)
+    {
+        system.x[kept] = system.x[i];
+        system.y[kept] = system.y[i];
+        system.dx[kept] = system.dx[i];
+        system.dy[kept] = system.dy[i];
+        system.life[kept] = system.life[i];
+        system.effect[kept] = system.effect[i];
+        kept += system.life[i] > 0;
+    }
+    system.count = kept;
+}
+
+void batch_particles(particle_system &system, const rectangle &view)
+{
+    particle_batch &batch = system.batch;
+
+    // only the cells the last frame covered need clearing
+    for (size_t c = 0; c < batch.covered.size(); c++)
+    {
+        uint32_t cell = batch.covered[c];
+        batch.red[cell] = batch.green[cell] = batch.blue[cell] = batch.weight[cell] = 0;
+    }
+    batch.covered.clear();
+
+    float left = view.x, top = view.y;
+    float per_cell = 1.0f / PARTICLE_CELL;
+
+    for (size_t i = 0; i < system.count; i++)
+    {
+        float px = (system.x[i] - left) * per_cell, py = (system.y[i] - top) * per_cell;
+        if (px < 0 or py < 0 or px >= batch.columns or py >= batch.rows)
+            continue;
+
+        uint32_t cell = (uint32_t)py * batch.columns + (uint32_t)px;
+        const particle_effect_data &data = PARTICLE_EFFECTS[system.effect[i]];
+        float fade = system.life[i] / data.lifetime;
+
+        if (batch.weight[cell] == 0)
+            batch.covered.push_back(cell);
+
+        batch.red[cell] += data.tint.r * fade;
+        batch.green[cell] += data.tint.g * fade;
+        batch.blue[cell] += data.tint.b * fade;
+        batch.weight[cell] += fade;
+    }
+}
+
+void draw_particles(particle_system &system, const rectangle &view, render_list &frame)
+{
+    batch_particles(system, view);
+    const particle_batch &batch = system.batch;
+
+    for (size_t c = 0; c < batch.covered.size(); c++)
+    {
+        uint32_t cell = batch.covered[c];
+        float weight = batch.weight[cell];
+
+        // the colour is the average of the particles, crowded cells are more solid
+        color tint = rgba_color(batch.red[cell] / weight, batch.green[cell] / weight, batch.blue[cell] / weight, min(1.0f, weight * PARTICLE_CELL_ALPHA));
+        record_fill_rectangle(frame, LAYER_EFFECTS, tint, (cell % batch.columns) * PARTICLE_CELL, (cell / batch.columns) * PARTICLE_CELL, PARTICLE_CELL, PARTICLE_CELL);
+    }
+}
+
+void run_particle_benchmark(int count)
+{
+    particle_system system = new_particle_system(count);
+    rectangle view = rectangle_from(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+    game_rng rng = new_rng(count);
+
+    double update_ms = 0, batch_ms = 0, worst_ms = 0;
+    size_t live = 0, cells = 0;
+
+    for (int frame = 0; frame < PARTICLE_BENCH_FRAMES; frame++)
+    {
+        auto start = chrono::steady_clock::now();
+
+        // bursts go off all over the screen until the system is full again
+        while (system.count + PARTICLE_EFFECTS[EXPLOSION].count <= (size_t)count)
+        {
+            particle_effect effect = (particle_effect)rng_int(rng, 0, PARTICLE_EFFECT_COUNT);
+            emit_particles(system, effect, rng_float(rng) * WINDOW_WIDTH, rng_float(rng) * WINDOW_HEIGHT);
+        }
+        update_particles(system);
+        auto updated = chrono::steady_clock::now();
+
+        batch_particles(system, view);
+        auto batched = chrono::steady_clock::now();
+
+        double frame_update = chrono::duration<double, milli>(updated - start).count();
+        double frame_batch = chrono::duration<double, milli>(batched - updated).count();
+        update_ms += frame_update;
+        batch_ms += frame_batch;
+        worst_ms = max(worst_ms, frame_update + frame_batch);
+        live += system.count;
+        cells += system.batch.covered.size();
+    }
+
+    double budget_ms = 1000.0 / 60;
+    write_line(to_string(live / PARTICLE_BENCH_FRAMES) + " live particles: update " + to_string(update_ms / PARTICLE_BENCH_FRAMES) + " ms, batch " + to_string(batch_ms / PARTICLE_BENCH_FRAMES) + " ms, worst frame " + to_string(worst_ms) + " ms");
+    write_line(to_string(cells / PARTICLE_BENCH_FRAMES) + " rectangles drawn per frame, " + (worst_ms <= budget_ms ? "holds" : "misses") + " 60 Hz");
+}
+
+//                                      ●▬▬▬▬   »»»       world.𝗵       «««  ▬▬▬▬▬●
+
+#define CHUNK_SIZE 1000
+#define ACTIVE_CHUNK_RADIUS 1
+#define ENTITIES_PER_CHUNK 6
+#define CHUNK_CACHE_SIZE 512
+#define CHUNK_CACHE_DIR "world_cache"
+#define WORLD_FOLDER_NAME "world_"
+
+/**
+ * The chunk store keeps every chunk that is not near the player.
+ * Chunks are saved as compact byte records, the most recently used ones
+ * are kept in memory and the rest are spilled to disk.
+ * 
+ * @field   recent      chunk records in most recently used order (front is newest)
+ * @field   in_memory   lookup from chunk id to its place in the recent list
+ * @field   on_disk     chunk ids whose record was spilled to the cache folder
+ * @field   generated   chunk ids that already got their starting entities
+ * @field   stored      total number of entities kept in the store
+ * @field   folder      the folder this store spills to, every world has its own
+ */
+struct chunk_store
+{
+    list<pair<long long, vector<uint8_t>>> recent;
+    unordered_map<long long, list<pair<long long, vector<uint8_t>>>::iterator> in_memory;
+    unordered_set<long long> on_disk;
+    unordered_set<long long> generated;
+    long long stored;
+    string folder;
+};
+
+/**
+ * The world data splits space into fixed size chunks. Chunks around the player
+ * are active (their entities are in the game's entity registry), all the others
+ * are kept in the chunk store.
+ * 
+ * @field   store           the saved chunks
+ * @field   loaded          chunk ids that are currently active
+ * @field   centre_chunk    chunk id the player was in on the last update
+ */
+struct world_data
+{
+    chunk_store store;
+    unordered_set<long long> loaded;
+    long long centre_chunk;
+};
+
+/**
+ * Creates an empty world with nothing loaded and an empty cache folder.
+ * 
+ * @param id    picks the world's own folder in the cache, worlds that are
+ *              alive at the same time need different ids
+ */
+world_data new_world(uint64_t id);
+
+/**
+ * Marks the entities of an archetype that are outside the chunks around the player.
+ * This only writes the archetype's far flags so it can run as a system.
+ * 
+ * @param archetype     the entities being tested
+ * @param player        the position of the player
+ */
+void mark_far_entities(archetype_data &archetype, const point_2d &player);
+
+/**
+ * Loads the chunks around the player and saves the chunks that are now too far,
+ * moving their entities in and out of the active entities.
+ * Entities marked far are saved and only marked as dead, remove_dead_entities takes them out.
+ * 
+ * @param world     the world being updated
+ * @param active    the active entities of the game
+ * @param player    the position of the player
+ * @param rng       the random numbers of the game, for the chunks being created
+ */
+void update_world(world_data &world, entity_registry &active, const point_2d &player, game_rng &rng);
+
+/**
+ * Removes the active entities and forgets every saved chunk,
+ * used when the game ends.
+ * 
+ * @param world     the world being cleared
+ * @param active    the active entities of the game
+ */
+void free_world(world_data &world, entity_registry &active);
+
+/**
+ * Tests a packed list of positions against an area, eight at a time with AVX
+ * or four at a time with SSE.
+ * 
+ * @param xs, ys    the packed positions
+ * @param count     number of positions
+ * @param area      the area the positions should be in
+ * @param outside   set to 1 for every position outside the area, 0 otherwise
+ */
+void mark_outside_area(const float *xs, const float *ys, size_t count, const rectangle &area, uint8_t *outside);
+
+//                                      ●▬▬▬▬   »»»       world.cpp       «««  ▬▬▬▬▬●
+
+// bytes used by one saved entity: type, x and y inside the chunk, dx and dy
+#define SAVED_ENTITY_SIZE 7
+// saved positions and velocities are kept in 1/32 of a pixel
+#define SAVED_SCALE 32.0
+
+/**
+ * Packs the chunk coordinates into one number so it can be used as a key.
+ */
+long long chunk_id(int cx, int cy)
+{
+    return ((long long)cx << 32) | (unsigned int)cy;
+}
+
+int chunk_x(long long id)
+{
+    return (int)(id >> 32);
+}
+
+int chunk_y(long long id)
+{
+    return (int)(unsigned int)(id & 0xffffffff);
+}
+
+/**
+ * Finds the chunk that contains a point in the world.
+ */
+long long chunk_at(double x, double y)
+{
+    return chunk_id((int)floor(x / CHUNK_SIZE), (int)floor(y / CHUNK_SIZE));
+}
+
+string chunk_file(const chunk_store &store, long long id)
+{
+    return store.folder + "/" + to_string(chunk_x(id)) + "_" + to_string(chunk_y(id)) + ".chunk";
+}
+
+/**
+ * Adds one entity to the end of a chunk record.
+ * The position is stored relative to the chunk so it fits in 16 bits.
+ */
+void save_entity(vector<uint8_t> &record, long long id, const entity_data &entity)
+{
+    double local_x = entity.x - (double)chunk_x(id) * CHUNK_SIZE;
+    double local_y = entity.y - (double)chunk_y(id) * CHUNK_SIZE;
+
+    uint16_t x = (uint16_t)clamp(local_x * SAVED_SCALE, 0.0, 65535.0);
+    uint16_t y = (uint16_t)clamp(local_y * SAVED_SCALE, 0.0, 65535.0);
+    int8_t dx = (int8_t)clamp(entity.dx * SAVED_SCALE, -127.0, 127.0);
+    int8_t dy = (int8_t)clamp(entity.dy * SAVED_SCALE, -127.0, 127.0);
+
+    record.push_back((uint8_t)entity.type);
+    record.push_back(x & 0xff);
+    record.push_back(x >> 8);
+    record.push_back(y & 0xff);
+    record.push_back(y >> 8);
+    record.push_back((uint8_t)dx);
+    record.push_back((uint8_t)dy);
+}
+
+/**
+ * Turns a chunk record back into active entities.
+ */
+void restore_entities(const vector<uint8_t> &record, long long id, entity_registry &active)
+{
+    for (size_t i = 0; i + SAVED_ENTITY_SIZE <= record.size(); i += SAVED_ENTITY_SIZE)
+    {
+        entity_type type = static_cast<entity_type>(record[i]);
+        double x = (record[i + 1] | record[i + 2] << 8) / SAVED_SCALE + (double)chunk_x(id) * CHUNK_SIZE;
+        double y = (record[i + 3] | record[i + 4] << 8) / SAVED_SCALE + (double)chunk_y(id) * CHUNK_SIZE;
+        double dx = (int8_t)record[i + 5] / SAVED_SCALE;
+        double dy = (int8_t)record[i + 6] / SAVED_SCALE;
+
+        spawn_into(active, create_entity(type, x, y, dx, dy));
+    }
+}
+
+/**
+ * Takes a chunk record out of the store, looking in memory first and then on disk.
+ * 
+ * @return  the record, empty if the chunk has nothing saved
+ */
+vector<uint8_t> take_chunk(chunk_store &store, long long id)
+{
+    vector<uint8_t> record;
+
+    auto found = store.in_memory.find(id);
+    if (found != store.in_memory.end())
+    {
+        record = move(found->second->second);
+        store.recent.erase(found->second);
+        store.in_memory.erase(found);
+    }
+    else if (store.on_disk.erase(id))
+    {
+        ifstream file(chunk_file(store, id), ios::binary);
+        record.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        file.close();
+        remove(chunk_file(store, id).c_str());
+    }
+
+    store.stored -= record.size() / SAVED_ENTITY_SIZE;
+    return record;
+}
+
+/**
+ * Puts a chunk record into the store as the most recently used one.
+ * If there are too many chunks in memory the oldest one is written to disk.
+ */
+void put_chunk(chunk_store &store, long long id, vector<uint8_t> record)
+{
+    store.stored += record.size() / SAVED_ENTITY_SIZE;
+    store.recent.emplace_front(id, move(record));
+    store.in_memory[id] = store.recent.begin();
+
+    if (store.recent.size() > CHUNK_CACHE_SIZE)
+    {
+        long long oldest = store.recent.back().first;
+        const vector<uint8_t> &data = store.recent.back().second;
+
+        // empty chunks only need to be remembered as generated
+        if (not data.empty())
+        {
+            ofstream file(chunk_file(store, oldest), ios::binary);
+            file.write((const char *)data.data(), data.size());
+            store.on_disk.insert(oldest);
+        }
+
+        store.in_memory.erase(oldest);
+        store.recent.pop_back();
+    }
+}
+
+/**
+ * Fills a chunk the player has never visited with random entities.
+ */
+void generate_chunk(long long id, entity_registry &active, game_rng &rng)
+{
+    vector<entity_type> types;
+    sample_spawn_types(ENTITIES_PER_CHUNK, types, rng);
+
+    for (size_t i = 0; i < types.size(); i++)
+    {
+        double x = (double)chunk_x(id) * CHUNK_SIZE + rng_float(rng) * CHUNK_SIZE;
+        double y = (double)chunk_y(id) * CHUNK_SIZE + rng_float(rng) * CHUNK_SIZE;
+        spawn_into(active, entity_spawn(types[i], x, y, rng));
+    }
+}
+
+void mark_outside_area(const float *xs, const float *ys, size_t count, const rectangle &area, uint8_t *outside)
+{
+    float left = area.x, top = area.y;
+    float right = area.x + area.width, bottom = area.y + area.height;
+    size_t i = 0;
+
+#if defined(__AVX__)
+    __m256 wide_min_x = _mm256_set1_ps(left), wide_min_y = _mm256_set1_ps(top);
+    __m256 wide_max_x = _mm256_set1_ps(right), wide_max_y = _mm256_set1_ps(bottom);
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(xs + i);
+        __m256 y = _mm256_loadu_ps(ys + i);
+
+        __m256 out = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(x, wide_min_x, _CMP_LT_OQ), _mm256_cmp_ps(x, wide_max_x, _CMP_GE_OQ)),
+                                  _mm256_or_ps(_mm256_cmp_ps(y, wide_min_y, _CMP_LT_OQ), _mm256_cmp_ps(y, wide_max_y, _CMP_GE_OQ)));
+        int mask = _mm256_movemask_ps(out);
+
+        for (int lane = 0; lane < 8; lane++)
+        {
+            outside[i + lane] = (mask >> lane) & 1;
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    __m128 min_x = _mm_set1_ps(left), min_y = _mm_set1_ps(top);
+    __m128 max_x = _mm_set1_ps(right), max_y = _mm_set1_ps(bottom);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(xs + i);
+        __m128 y = _mm_loadu_ps(ys + i);
+
+        __m128 out = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(x, min_x), _mm_cmpge_ps(x, max_x)),
+                               _mm_or_ps(_mm_cmplt_ps(y, min_y), _mm_cmpge_ps(y, max_y)));
+        int mask = _mm_movemask_ps(out);
+
+        outside[i] = mask & 1;
+        outside[i + 1] = (mask >> 1) & 1;
+        outside[i + 2] = (mask >> 2) & 1;
+        outside[i + 3] = (mask >> 3) & 1;
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        outside[i] = xs[i] < left or xs[i] >= right or ys[i] < top or ys[i] >= bottom;
+    }
+}
+
+bool chunk_in_range(long long id, long long centre)
+{
+    return abs(chunk_x(id) - chunk_x(centre)) <= ACTIVE_CHUNK_RADIUS and abs(chunk_y(id) - chunk_y(centre)) <= ACTIVE_CHUNK_RADIUS;
+}
+
+world_data new_world(uint64_t id)
+{
+    world_data result;
+
+    result.store.stored = 0;
+    result.store.folder = string(CHUNK_CACHE_DIR) + "/" + WORLD_FOLDER_NAME + to_string(id);
+    result.centre_chunk = chunk_id(INT_MAX, INT_MAX);
+
+    // chunks spilled by an earlier game are not part of this world
+    error_code ignored;
+    filesystem::remove_all(result.store.folder, ignored);
+    filesystem::create_directories(result.store.folder, ignored);
+
+    return result;
+}
+
+void mark_far_entities(archetype_data &archetype, const point_2d &player)
+{
+    long long centre = chunk_at(player.x, player.y);
+    size_t count = entity_count(archetype.entities);
+
+    // the active chunks form one square around the centre chunk
+    rectangle area;
+    area.x = (double)(chunk_x(centre) - ACTIVE_CHUNK_RADIUS) * CHUNK_SIZE;
+    area.y = (double)(chunk_y(centre) - ACTIVE_CHUNK_RADIUS) * CHUNK_SIZE;
+    area.width = area.height = (2 * ACTIVE_CHUNK_RADIUS + 1) * CHUNK_SIZE;
+
+    archetype.far.resize(count);
+    mark_outside_area(archetype.entities.x.data(), archetype.entities.y.data(), count, area, archetype.far.data());
+}
+
+void update_world(world_data &world, entity_registry &active, const point_2d &player, game_rng &rng)
+{
+    long long centre = chunk_at(player.x, player.y);
+
+    // entities that drifted out of the active chunks are saved with the chunk they are in now
+    for (size_t a = 0; a < active.archetypes.size(); a++)
+    {
+        entity_store &entities = active.archetypes[a].entities;
+        const vector<uint8_t> &far = active.archetypes[a].far;
+
+        for (size_t i = 0; i < far.size() and i < entity_count(entities); i++)
+        {
+            if (not far[i] or entities.dead[i])
+                continue;
+
+            // it may have moved back in since it was marked
+            long long id = chunk_at(entities.x[i], entities.y[i]);
+            if (chunk_in_range(id, centre))
+                continue;
+
+            vector<uint8_t> record = take_chunk(world.store, id);
+            save_entity(record, id, entity_at(entities, i));
+            put_chunk(world.store, id, move(record));
+
+            entities.dead[i] = true;
+        }
+    }
+
+    if (centre == world.centre_chunk)
+        return;
+    world.centre_chunk = centre;
+
+    // chunks that are now too far only need their record to exist, their entities were saved above
+    for (auto it = world.loaded.begin(); it != world.loaded.end();)
+    {
+        if (chunk_in_range(*it, centre))
+        {
+            it++;
+            continue;
+        }
+
+        put_chunk(world.store, *it, take_chunk(world.store, *it));
+        it = world.loaded.erase(it);
+    }
+
+    // load the chunks that came into range, creating them if they were never visited
+    for (int cx = chunk_x(centre) - ACTIVE_CHUNK_RADIUS; cx <= chunk_x(centre) + ACTIVE_CHUNK_RADIUS; cx++)
+    {
+        for (int cy = chunk_y(centre) - ACTIVE_CHUNK_RADIUS; cy <= chunk_y(centre) + ACTIVE_CHUNK_RADIUS; cy++)
+        {
+            long long id = chunk_id(cx, cy);
+            if (not world.loaded.insert(id).second)
+                continue;
+
+            // a new chunk may already hold entities that drifted into it
+            restore_entities(take_chunk(world.store, id), id, active);
+            if (world.store.generated.insert(id).second)
+                generate_chunk(id, active, rng);
+        }
+    }
+}
+
+void free_world(world_data &world, entity_registry &active)
+{
+    clear_entities(active);
+
+    world.loaded.clear();
+    world.store.recent.clear();
+    world.store.in_memory.clear();
+    world.store.on_disk.clear();
+    world.store.generated.clear();
+    world.store.stored = 0;
+
+    error_code ignored;
+    filesystem::remove_all(world.store.folder, ignored);
+}
+
+//                                      ●▬▬▬▬   »»»       gravity.𝗵       «««  ▬▬▬▬▬●
+
+#define GRAVITY_CELLS 32
+#define GRAVITY_REACH CHUNK_SIZE
+#define GRAVITY_PLANET_CHANCE 0.35f
+#define GRAVITY_MAX_SPEED 4
+#define GRAVITY_DIRECT_BODIES 32
+#define GRAVITY_THETA 0.5f
+#define GRAVITY_CACHE_RADIUS (ACTIVE_CHUNK_RADIUS + 1)
+#define GRAVITY_ACTIVE_SIDE (2 * ACTIVE_CHUNK_RADIUS + 1)
+#define GRAVITY_BENCH_SAMPLES 1000000
+
+/**
+ * The planets, one for each planet picture.
+ */
+enum planet_kind : uint8_t
+{
+    MERCURY,
+    MARS,
+    EARTH,
+    NEPTUNE,
+    JUPITER,
+    PLUTO,
+    PLANET_KIND_COUNT
+};
+
+/**
+ * Everything that makes one planet different from the others.
+ * 
+ * @field   bitmap_name     name of the planet's bitmap in the resource bundle
+ * @field   radius          radius the planet is drawn at, the pull is softened inside it
+ * @field   mass            how hard it pulls, the acceleration at distance r is about mass / r²
+ */
+struct planet_archetype
+{
+    const char *bitmap_name;
+    float radius;
+    float mass;
+};
+
+/**
+ * One row per planet, in the same order as planet_kind.
+ */
+constexpr planet_archetype PLANET_ARCHETYPES[] = {
+    // bitmap   radius  mass
+    {"mercury", 40,     250},
+    {"mars",    55,     450},
+    {"earth",   70,     800},
+    {"neptune", 90,     1200},
+    {"jupiter", 130,    2000},
+    {"pluto",   30,     150},
+};
+
+static_assert(sizeof(PLANET_ARCHETYPES) / sizeof(PLANET_ARCHETYPES[0]) == PLANET_KIND_COUNT, "every planet needs exactly one row");
+
+/**
+ * Anything that pulls. Planets are bodies, and so are the groups of
+ * bodies the Barnes-Hut tree stands in for when they are far enough away.
+ * 
+ * @field   x, y        centre of the body
+ * @field   mass        how hard it pulls
+ * @field   soften      distance inside which the pull stops growing
+ * @field   kind        which planet it is, only used for drawing
+ */
+struct gravity_body
+{
+    float x, y;
+    float mass;
+    float soften;
+    planet_kind kind;
+};
+
+/**
+ * One square of the Barnes-Hut tree.
+ * 
+ * @field   left, top, side     the square
+ * @field   x, y                centre of mass of the bodies inside, the sum of mass times position while building
+ * @field   mass, soften        total mass and the mass weighted softening of the bodies inside
+ * @field   first_child         index of the first of the four children, -1 for a leaf
+ * @field   body                the body in a leaf, -1 if the leaf is empty
+ */
+struct gravity_node
+{
+    float left, top, side;
+    float x, y;
+    float mass, soften;
+    int first_child;
+    int body;
+};
+
+/**
+ * The accelerations sampled on a GRAVITY_CELLS grid over one chunk,
+ * GRAVITY_CELLS + 1 samples along each side so neighbouring chunks share their edges.
+ * 
+ * @field   ax, ay      acceleration at each sample, row by row
+ * @field   empty       true when no planet reaches the chunk, every sample is then 0
+ */
+struct gravity_grid
+{
+    vector<float> ax, ay;
+    bool empty;
+};
+
+/**
+ * The gravity field of a world. Planets come from the seed and the chunk
+ * id alone, so they never need saving. The pull of the planets near the
+ * player is worked out once per chunk into a grid, and every entity only
+ * reads the four samples around it.
+ * 
+ * @field   seed            picks where the planets are
+ * @field   grids           grids of the chunks around the player, kept a ring further so going back is free
+ * @field   centre          chunk id the active grids are around
+ * @field   left, top       corner of the active chunks
+ * @field   active          grids of the active chunks, row by row, so sampling needs no lookup
+ * @field   planets         the planets that can pull on or be seen from the active chunks
+ * @field   tree            reused by the Barnes-Hut tree
+ */
+struct gravity_field
+{
+    uint64_t seed;
+    unordered_map<long long, gravity_grid> grids;
+    long long centre;
+    float left, top;
+    const gravity_grid *active[GRAVITY_ACTIVE_SIDE * GRAVITY_ACTIVE_SIDE];
+    vector<gravity_body> planets;
+    vector<gravity_node> tree;
+};
+
+/**
+ * Creates the gravity field of a world with no grids worked out yet.
+ * 
+ * @param seed  picks where the planets are
+ */
+gravity_field new_gravity_field(uint64_t seed);
+
+/**
+ * Adds the planets of one chunk to a list.
+ * 
+ * @param field     the gravity field
+ * @param id        the chunk
+ * @param bodies    the list the planets are added to
+ */
+void chunk_planets(const gravity_field &field, long long id, vector<gravity_body> &bodies);
+
+/**
+ * Works out the grids of the chunks around the player that are not cached
+ * yet and forgets the ones too far away. Only does anything when the player
+ * moved to another chunk. This must run before the systems that sample the field.
+ * 
+ * @param field     the gravity field
+ * @param player    the position of the player
+ */
+void prepare_gravity(gravity_field &field, const point_2d &player);
+
+/**
+ * Samples the acceleration at a point, interpolated from the four grid
+ * samples around it. Points outside the active chunks are not pulled.
+ * 
+ * @param field     the gravity field, prepared for this update
+ * @param x, y      the point
+ * @param ax, ay    set to the acceleration
+ */
+void sample_gravity(const gravity_field &field, float x, float y, float &ax, float &ay);
+
+/**
+ * Fills the grid of a chunk from a list of bodies, summing every body
+ * for each sample when there are only a few of them and walking a
+ * Barnes-Hut tree when there are more than GRAVITY_DIRECT_BODIES.
+ * 
+ * @param bodies    everything that pulls on the chunk
+ * @param id        the chunk
+ * @param tree      reused for the Barnes-Hut tree
+ * @param grid      filled with the accelerations
+ */
+void build_gravity_grid(const vector<gravity_body> &bodies, long long id, vector<gravity_node> &tree, gravity_grid &grid);
+
+/**
+ * Looks up the bitmap of every planet once, after the resources are loaded.
+ */
+void load_planet_bitmaps();
+
+/**
+ * Draws the planets inside a view to the screen.
+ * 
+ * @param field     the gravity field
+ * @param view      the part of the world on the screen
+ * @param zoom      how big the world is drawn
+ * @param frame     the frame being recorded
+ */
+void draw_planets(const gravity_field &field, const rectangle &view, float zoom, render_list &frame);
+
+/**
+ * Builds a chunk's grid from count bodies, summing every body and with the
+ * Barnes-Hut tree, and compares both with summing every body for each entity.
+ * 
+ * @param count     bodies around the chunk
+ */
+void run_gravity_benchmark(int count);
+
+//                                      ●▬▬▬▬   »»»       gravity.cpp       «««  ▬▬▬▬▬●
+
+// the bitmap of each planet, filled by load_planet_bitmaps
+bitmap planet_bitmaps[PLANET_KIND_COUNT];
+
+gravity_field new_gravity_field(uint64_t seed)
+{
+    gravity_field result;
+    result.seed = seed;
+    result.centre = chunk_id(INT_MAX, INT_MAX);
+
+    // nothing is pulled until the first prepare_gravity
+    result.left = result.top = INFINITY;
+    fill(begin(result.active), end(result.active), nullptr);
+    return result;
+}
+
+void chunk_planets(const gravity_field &field, long long id, vector<gravity_body> &bodies)
+{
+    // every chunk gets its own random numbers, so a chunk always has the same planet
+    game_rng rng = new_rng(field.seed ^ ((uint64_t)id * 0x9e3779b97f4a7c15ULL));
+    if (rng_float(rng) >= GRAVITY_PLANET_CHANCE)
+        return;
+
+    gravity_body planet;
+    planet.kind = (planet_kind)rng_int(rng, 0, PLANET_KIND_COUNT);
+    const planet_archetype &archetype = PLANET_ARCHETYPES[planet.kind];
+
+    // planets stay inside their chunk
+    float room = CHUNK_SIZE - 2 * archetype.radius;
+    planet.x = (float)chunk_x(id) * CHUNK_SIZE + archetype.radius + rng_float(rng) * room;
+    planet.y = (float)chunk_y(id) * CHUNK_SIZE + archetype.radius + rng_float(rng) * room;
+    planet.mass = archetype.mass;
+    planet.soften = archetype.radius;
+    bodies.push_back(planet);
+}
+
+/**
+ * adds the pull of one body to an acceleration. the pull fades out
+ * smoothly at GRAVITY_REACH, so a chunk only needs the planets of its neighbours
+ */
+void add_pull(float dx, float dy, float mass, float soften, float &ax, float &ay)
+{
+    const float reach2 = (float)GRAVITY_REACH * GRAVITY_REACH;
+    float distance2 = dx * dx + dy * dy;
+    if (distance2 >= reach2)
+        return;
+
+    float fade = 1 - distance2 / reach2;
+    float softened = distance2 + soften * soften;
+    float strength = mass * fade * fade / (softened * sqrt(softened));
+    ax += dx * strength;
+    ay += dy * strength;
+}
+
+/**
+ * adds a body to the tree below a node, splitting leaves that already hold one
+ */
+void insert_gravity_body(vector<gravity_node> &tree, const vector<gravity_body> &bodies, int node, int body)
+{
+    const gravity_body &added = bodies[body];
+
+    while (true)
+    {
+        tree[node].x += added.mass * added.x;
+        tree[node].y += added.mass * added.y;
+        tree[node].mass += added.mass;
+        tree[node].soften += added.mass * added.soften;
+
+        if (tree[node].first_child < 0)
+        {
+            if (tree[node].body < 0)
+            {
+                tree[node].body = body;
+                return;
+            }
+
+            // bodies on top of each other stay together in one leaf
+            if (tree[node].side < 1)
+                return;
+
+            int first = tree.size();
+            float half = tree[node].side / 2;
+            for (int quarter = 0; quarter < 4; quarter++)
+            {
+                tree.push_back({tree[node].left + (quarter & 1) * half, tree[node].top + (quarter >> 1) * half, half, 0, 0, 0, 0, -1, -1});
+            }
+
+            // the body that was here moves down to one of the children
+            int moved = tree[node].body;
+            tree[node].first_child = first;
+            tree[node].body = -1;
+
+            int child = first + (bodies[moved].x >= tree[node].left + half) + 2 * (bodies[moved].y >= tree[node].top + half);
+            tree[child].x = bodies[moved].mass * bodies[moved].x;
+            tree[child].y = bodies[moved].mass * bodies[moved].y;
+            tree[child].mass = bodies[moved].mass;
+            tree[child].soften = bodies[moved].mass * bodies[moved].soften;
+            tree[child].body = moved;
+        }
+
+        float half = tree[node].side / 2;
+        node = tree[node].first_child + (added.x >= tree[node].left + half) + 2 * (added.y >= tree[node].top + half);
+    }
+}
+
+/**
+ * builds the Barnes-Hut tree of a list of bodies, the root is tree[0]
+ */
+void build_gravity_tree(const vector<gravity_body> &bodies, vector<gravity_node> &tree)
+{
+    float left = bodies[0].x, top = bodies[0].y, right = left, bottom = top;
+    for (size_t i = 1; i < bodies.size(); i++)
+    {
+        left = min(left, bodies[i].x);
+        top = min(top, bodies[i].y);
+        right = max(right, bodies[i].x);
+        bottom = max(bottom, bodies[i].y);
+    }
+
+    tree.clear();
+    tree.push_back({left, top, max(right - left, bottom - top) + 1, 0, 0, 0, 0, -1, -1});
+    for (size_t i = 0; i < bodies.size(); i++)
+    {
+        insert_gravity_body(tree, bodies, 0, i);
+    }
+
+    // the sums of mass times position and softening become centres of mass and mean softenings
+    for (size_t n = 0; n < tree.size(); n++)
+    {
+        if (tree[n].mass > 0)
+        {
+            tree[n].x /= tree[n].mass;
+            tree[n].y /= tree[n].mass;
+            tree[n].soften /= tree[n].mass;
+        }
+    }
+}
+
+/**
+ * the acceleration at a point from a Barnes-Hut tree. squares that look
+ * small enough from the point pull as one body from their centre of mass.
+ * the softening counts towards the size, as a softened square pulls
+ * nothing like one body until the point is well clear of it
+ */
+void tree_pull(const vector<gravity_node> &tree, float x, float y, float &ax, float &ay)
+{
+    int stack[128];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+        const gravity_node &node = tree[stack[--top]];
+        if (node.mass == 0)
+            continue;
+
+        float dx = node.x - x, dy = node.y - y;
+        if (node.first_child < 0 or (node.side + node.soften) * (node.side + node.soften) < GRAVITY_THETA * GRAVITY_THETA * (dx * dx + dy * dy))
+        {
+            add_pull(dx, dy, node.mass, node.soften, ax, ay);
+            continue;
+        }
+
+        // squares under a pixel are not split, so the tree is only a dozen or so levels deep
+        for (int quarter = 0; quarter < 4; quarter++)
+        {
+            stack[top++] = node.first_child + quarter;
+        }
+    }
+}
+
+/**
+ * fills the grid of a chunk, either summing every body for each sample or walking the tree
+ */
+void fill_gravity_grid(const vector<gravity_body> &bodies, long long id, vector<gravity_node> &tree, gravity_grid &grid, bool use_tree)
+{
+    const int side = GRAVITY_CELLS + 1;
+    const float cell = (float)CHUNK_SIZE / GRAVITY_CELLS;
+    float left = (float)chunk_x(id) * CHUNK_SIZE, top = (float)chunk_y(id) * CHUNK_SIZE;
+
+    grid.ax.assign(side * side, 0);
+    grid.ay.assign(side * side, 0);
+    grid.empty = bodies.empty();
+    if (grid.empty)
+        return;
+
+    if (use_tree)
+        build_gravity_tree(bodies, tree);
+
+    for (int row = 0; row < side; row++)
+    {
+        for (int column = 0; column < side; column++)
+        {
+            float x = left + column * cell, y = top + row * cell;
+            float ax = 0, ay = 0;
+
+            if (use_tree)
+            {
+                tree_pull(tree, x, y, ax, ay);
+            }
+            else
+            {
+                for (size_t i = 0; i < bodies.size(); i++)
+                {
+                    add_pull(bodies[i].x - x, bodies[i].y - y, bodies[i].mass, bodies[i].soften, ax, ay);
+                }
+            }
+
+            grid.ax[row * side + column] = ax;
+            grid.ay[row * side + column] = ay;
+        }
+    }
+}
+
+void build_gravity_grid(const vector<gravity_body> &bodies, long long id, vector<gravity_node> &tree, gravity_grid &grid)
+{
+    fill_gravity_grid(bodies, id, tree, grid, bodies.size() > GRAVITY_DIRECT_BODIES);
+}
+
+bool chunk_within(long long id, long long centre, int radius)
+{
+    return abs(chunk_x(id) - chunk_x(centre)) <= radius and abs(chunk_y(id) - chunk_y(centre)) <= radius;
+}
+
+void prepare_gravity(gravity_field &field, const point_2d &player)
+{
+    long long centre = chunk_at(player.x, player.y);
+    if (centre == field.centre)
+        return;
+    field.centre = centre;
+    field.left = (float)(chunk_x(centre) - ACTIVE_CHUNK_RADIUS) * CHUNK_SIZE;
+    field.top = (float)(chunk_y(centre) - ACTIVE_CHUNK_RADIUS) * CHUNK_SIZE;
+
+    for (auto it = field.grids.begin(); it != field.grids.end();)
+    {
+        if (chunk_within(it->first, centre, GRAVITY_CACHE_RADIUS))
+            ++it;
+        else
+            it = field.grids.erase(it);
+    }
+
+    // a planet pulls as far as the next chunk, so the active chunks and one ring around them
+    field.planets.clear();
+    for (int cy = -ACTIVE_CHUNK_RADIUS - 1; cy <= ACTIVE_CHUNK_RADIUS + 1; cy++)
+    {
+        for (int cx = -ACTIVE_CHUNK_RADIUS - 1; cx <= ACTIVE_CHUNK_RADIUS + 1; cx++)
+        {
+            chunk_planets(field, chunk_id(chunk_x(centre) + cx, chunk_y(centre) + cy), field.planets);
+        }
+    }
+
+    vector<gravity_body> nearby;
+    for (int cy = -ACTIVE_CHUNK_RADIUS; cy <= ACTIVE_CHUNK_RADIUS; cy++)
+    {
+        for (int cx = -ACTIVE_CHUNK_RADIUS; cx <= ACTIVE_CHUNK_RADIUS; cx++)
+        {
+            long long id = chunk_id(chunk_x(centre) + cx, chunk_y(centre) + cy);
+            auto found = field.grids.find(id);
+
+            if (found == field.grids.end())
+            {
+                nearby.clear();
+                for (int ny = -1; ny <= 1; ny++)
+                {
+                    for (int nx = -1; nx <= 1; nx++)
+                    {
+                        chunk_planets(field, chunk_id(chunk_x(id) + nx, chunk_y(id) + ny), nearby);
+                    }
+                }
+
+                found = field.grids.emplace(id, gravity_grid()).first;
+                build_gravity_grid(nearby, id, field.tree, found->second);
+            }
+
+            field.active[(cy + ACTIVE_CHUNK_RADIUS) * GRAVITY_ACTIVE_SIDE + cx + ACTIVE_CHUNK_RADIUS] = &found->second;
+        }
+    }
+}
+
+void sample_gravity(const gravity_field &field, float x, float y, float &ax, float &ay)
+{
+    ax = ay = 0;
+
+    // the point in grid cells from the corner of the active chunks
+    float u = (x - field.left) * ((float)GRAVITY_CELLS / CHUNK_SIZE);
+    float v = (y - field.top) * ((float)GRAVITY_CELLS / CHUNK_SIZE);
+    if (not(u >= 0 and v >= 0 and u < GRAVITY_ACTIVE_SIDE * GRAVITY_CELLS and v < GRAVITY_ACTIVE_SIDE * GRAVITY_CELLS))
+        return;
+
+    int cell_u = (int)u, cell_v = (int)v;
+    const gravity_grid &grid = *field.active[(cell_v / GRAVITY_CELLS) * GRAVITY_ACTIVE_SIDE + cell_u / GRAVITY_CELLS];
+    if (grid.empty)
+        return;
+
+    const int side = GRAVITY_CELLS + 1;
+    int s = (cell_v % GRAVITY_CELLS) * side + cell_u % GRAVITY_CELLS;
+    float fu = u - cell_u, fv = v - cell_v;
+
+    ax = (grid.ax[s] * (1 - fu) + grid.ax[s + 1] * fu) * (1 - fv) + (grid.ax[s + side] * (1 - fu) + grid.ax[s + side + 1] * fu) * fv;
+    ay = (grid.ay[s] * (1 - fu) + grid.ay[s + 1] * fu) * (1 - fv) + (grid.ay[s + side] * (1 - fu) + grid.ay[s + side + 1] * fu) * fv;
+}
+
+void load_planet_bitmaps()
+{
+    for (int i = 0; i < PLANET_KIND_COUNT; i++)
+    {
+        planet_bitmaps[i] = bitmap_named(PLANET_ARCHETYPES[i].bitmap_name);
+    }
+}
+
+void draw_planets(const gravity_field &field, const rectangle &view, float zoom, render_list &frame)
+{
+    for (size_t i = 0; i < field.planets.size(); i++)
+    {
+        const gravity_body &planet = field.planets[i];
+        float radius = PLANET_ARCHETYPES[planet.kind].radius;
+        if (planet.x + radius < view.x or planet.y + radius < view.y or planet.x - radius > view.x + view.width or planet.y - radius > view.y + view.height)
+            continue;
+
+        // bitmaps are scaled around their centre, so the centre is put on the planet
+        bitmap image = planet_bitmaps[planet.kind];
+        float scale = 2 * radius / bitmap_width(image) * zoom;
+        float sx = (planet.x - view.x) * zoom, sy = (planet.y - view.y) * zoom;
+        record_bitmap(frame, LAYER_PLANETS, image, sx - bitmap_width(image) / 2.0f, sy - bitmap_height(image) / 2.0f, scale);
+    }
+}
+
+void run_gravity_benchmark(int count)
+{
+    game_rng rng = new_rng(count);
+    vector<gravity_body> bodies;
+
+    // the bodies are spread over the chunk and its neighbours, like planets would be
+    for (int i = 0; i < count; i++)
+    {
+        planet_kind kind = (planet_kind)rng_int(rng, 0, PLANET_KIND_COUNT);
+        float x = (rng_float(rng) * 3 - 1) * CHUNK_SIZE, y = (rng_float(rng) * 3 - 1) * CHUNK_SIZE;
+        bodies.push_back({x, y, PLANET_ARCHETYPES[kind].mass, PLANET_ARCHETYPES[kind].radius, kind});
+    }
+
+    const long long id = chunk_id(0, 0);
+    vector<gravity_node> tree;
+    gravity_grid direct, approximate;
+
+    auto start = chrono::steady_clock::now();
+    fill_gravity_grid(bodies, id, tree, direct, false);
+    auto built_direct = chrono::steady_clock::now();
+
+    fill_gravity_grid(bodies, id, tree, approximate, true);
+    auto built_tree = chrono::steady_clock::now();
+
+    // the tree's error is measured against the strongest pull in the chunk
+    const int side = GRAVITY_CELLS + 1;
+    float strongest = 0, worst_error = 0;
+    for (int s = 0; s < side * side; s++)
+    {
+        strongest = max(strongest, sqrt(direct.ax[s] * direct.ax[s] + direct.ay[s] * direct.ay[s]));
+        float ex = approximate.ax[s] - direct.ax[s], ey = approximate.ay[s] - direct.ay[s];
+        worst_error = max(worst_error, sqrt(ex * ex + ey * ey));
+    }
+
+    // entities read the grid, which costs the same however many bodies there are
+    gravity_field field = new_gravity_field(0);
+    field.centre = id;
+    field.left = field.top = -ACTIVE_CHUNK_RADIUS * CHUNK_SIZE;
+    fill(begin(field.active), end(field.active), &approximate);
+
+    float total = 0;
+    auto sampling = chrono::steady_clock::now();
+    for (int i = 0; i < GRAVITY_BENCH_SAMPLES; i++)
+    {
+        float ax, ay;
+        sample_gravity(field, rng_float(rng) * CHUNK_SIZE, rng_float(rng) * CHUNK_SIZE, ax, ay);
+        total += ax + ay;
+    }
+    auto sampled = chrono::steady_clock::now();
+
+    const int summed_samples = GRAVITY_BENCH_SAMPLES / 100;
+    for (int i = 0; i < summed_samples; i++)
+    {
+        float ax = 0, ay = 0, x = rng_float(rng) * CHUNK_SIZE, y = rng_float(rng) * CHUNK_SIZE;
+        for (size_t b = 0; b < bodies.size(); b++)
+        {
+            add_pull(bodies[b].x - x, bodies[b].y - y, bodies[b].mass, bodies[b].soften, ax, ay);
+        }
+        total += ax + ay;
+    }
+    auto summed = chrono::steady_clock::now();
+
+    double direct_ms = chrono::duration<double, milli>(built_direct - start).count();
+    double tree_ms = chrono::duration<double, milli>(built_tree - built_direct).count();
+    double sample_ns = chrono::duration<double, nano>(sampled - sampling).count() / GRAVITY_BENCH_SAMPLES;
+    double summed_ns = chrono::duration<double, nano>(summed - sampled).count() / summed_samples;
+
+    write_line(to_string(count) + " bodies: grid summing every body " + to_string(direct_ms) + " ms, with the tree " + to_string(tree_ms) + " ms, worst tree error " + to_string(100 * worst_error / strongest) + "% of the strongest pull");
+    write_line("per entity: grid sample " + to_string(sample_ns) + " ns, summing every body " + to_string(summed_ns) + " ns (checksum " + to_string(total) + ")");
+}
+
+//                                      ●▬▬▬▬   »»»       flow_field.𝗵       «««  ▬▬▬▬▬●
+
+#define FLOW_CELL 50
+#define FLOW_PLANET_MARGIN 40
+#define FLOW_UNREACHABLE UINT16_MAX
+#define FLOW_STRAIGHT 8
+#define FOE_HUNT_SPEED 1.4f
+#define FOE_STEER 0.05f
+#define FOE_SEPARATION 90
+#define FOE_SEPARATION_WEIGHT 0.08f
+#define SWARM_BENCH_TICKS 600
+#define SWARM_BENCH_SPACING 100
+#define SWARM_BENCH_CELL 100
+
+/**
+ * A flow field leads everything on it to one target. It is a coarse grid
+ * where each cell holds the way to go from it, worked out once with a
+ * breadth first search from the target and shared by every foe, so no
+ * foe needs to find its own path around the planets.
+ * 
+ * The foes keep apart using the cells of the neighbour grid. Each cell's foes
+ * are added up once per update, and a foe only moves away from the middle of
+ * the foes in the cells around it. This keeps the cost per foe fixed however
+ * crowded the swarm gets.
+ * 
+ * @field   left, top       world position of the top left of the grid
+ * @field   cell            width and height of a cell
+ * @field   columns, rows   size of the grid in cells
+ * @field   blocked         1 for the cells a planet is in
+ * @field   steps           cells to the target from each cell, FLOW_UNREACHABLE if it can not be reached
+ * @field   way             which neighbour is the next cell on the way, FLOW_STRAIGHT to head straight
+ *                          for the target, one byte a cell so big fields stay in the cache
+ * @field   target_cell     the cell the field leads to, -1 when it needs working out again
+ * @field   frontier        reused by the search
+ * @field   crowd           number of foes in each cell of the neighbour grid
+ * @field   crowd_x, crowd_y    the centres of those foes added up
+ */
+struct flow_field
+{
+    float left, top;
+    float cell;
+    int columns, rows;
+    vector<uint8_t> blocked;
+    vector<uint16_t> steps;
+    vector<uint8_t> way;
+    int target_cell;
+    vector<uint32_t> frontier;
+    vector<uint32_t> crowd;
+    vector<float> crowd_x, crowd_y;
+};
+
+/**
+ * Creates a flow field that leads nowhere yet.
+ * 
+ * @param columns, rows     size of the grid in cells
+ * @param cell              width and height of a cell
+ */
+flow_field new_flow_field(int columns, int rows, float cell);
+
+/**
+ * Moves the grid and blocks the cells the planets are in. The field is
+ * worked out again on the next update.
+ * 
+ * @param field         the flow field
+ * @param left, top     world position of the top left of the grid
+ * @param planets       everything the foes need to go around
+ */
+void place_flow_field(flow_field &field, float left, float top, const vector<gravity_body> &planets);
+
+/**
+ * Points the field at a target. The search only runs again when the target
+ * moved past the cells around the last search or the grid was placed again,
+ * so most updates cost nothing.
+ * 
+ * @param field     the flow field
+ * @param target    where everything is led to
+ */
+void update_flow_field(flow_field &field, const point_2d &target);
+
+/**
+ * Adds up the foes in each cell of a neighbour grid, for steer_foes.
+ * 
+ * @param field     the flow field the foes are steered with
+ * @param index     the neighbour grid, built at the end of the last update
+ */
+void gather_crowd(flow_field &field, const spatial_index &index);
+
+/**
+ * Steers the foes of an entity store along a flow field, turning them a
+ * little each update towards the way the field points and away from the
+ * foes around them. Foes off the field head straight for the target, and
+ * sleeping foes are left alone.
+ * 
+ * @param entities  the foes
+ * @param archetype index of the foes' archetype, to find them in the neighbour grid
+ * @param field     the flow field, pointed at the target with the crowd gathered
+ * @param index     the neighbour grid the crowd was gathered from
+ * @param target    what the foes hunt
+ */
+void steer_foes(entity_store &entities, size_t archetype, const flow_field &field, const spatial_index &index, const point_2d &target);
+
+/**
+ * Has count foes hunt a moving target around scattered planets and times
+ * the flow field, the steering, the moves and the neighbour grid against
+ * the 60 Hz frame budget.
+ * 
+ * @param count     foes in the swarm
+ */
+void run_swarm_benchmark(int count);
+
+//                                      ●▬▬▬▬   »»»       flow_field.cpp       «««  ▬▬▬▬▬●
+
+flow_field new_flow_field(int columns, int rows, float cell)
+{
+    flow_field result;
+    result.left = result.top = 0;
+    result.cell = cell;
+    result.columns = columns;
+    result.rows = rows;
+    result.blocked.assign(columns * rows, 0);
+    result.steps.assign(columns * rows, FLOW_UNREACHABLE);
+    result.way.assign(columns * rows, FLOW_STRAIGHT);
+    result.target_cell = -1;
+    result.frontier.reserve(columns * rows);
+    return result;
+}
+
+void place_flow_field(flow_field &field, float left, float top, const vector<gravity_body> &planets)
+{
+    field.left = left;
+    field.top = top;
+    field.target_cell = -1;
+    fill(field.blocked.begin(), field.blocked.end(), 0);
+
+    for (size_t i = 0; i < planets.size(); i++)
+    {
+        float reach = PLANET_ARCHETYPES[planets[i].kind].radius + FLOW_PLANET_MARGIN;
+        int first_x = max(0, (int)floor((planets[i].x - reach - left) / field.cell));
+        int first_y = max(0, (int)floor((planets[i].y - reach - top) / field.cell));
+        int last_x = min(field.columns - 1, (int)floor((planets[i].x + reach - left) / field.cell));
+        int last_y = min(field.rows - 1, (int)floor((planets[i].y + reach - top) / field.cell));
+
+        // a cell is blocked when its centre is inside the planet and its margin
+        for (int cy = first_y; cy <= last_y; cy++)
+        {
+            for (int cx = first_x; cx <= last_x; cx++)
+            {
+                float dx = left + (cx + 0.5f) * field.cell - planets[i].x, dy = top + (cy + 0.5f) * field.cell - planets[i].y;
+                if (dx * dx + dy * dy <= reach * reach)
+                    field.blocked[cy * field.columns + cx] = 1;
+            }
+        }
+    }
+}
+
+// the eight neighbours of a cell, straight ones first, and the unit directions to them.
+// opposite neighbours are next to each other, so n ^ 1 is the way back from neighbour n
+constexpr int FLOW_NEIGHBOUR_X[] = {1, -1, 0, 0, 1, -1, 1, -1};
+constexpr int FLOW_NEIGHBOUR_Y[] = {0, 0, 1, -1, 1, -1, -1, 1};
+constexpr float FLOW_DIAGONAL = 0.70710678f;
+constexpr float FLOW_WAY_X[] = {1, -1, 0, 0, FLOW_DIAGONAL, -FLOW_DIAGONAL, FLOW_DIAGONAL, -FLOW_DIAGONAL};
+constexpr float FLOW_WAY_Y[] = {0, 0, 1, -1, FLOW_DIAGONAL, -FLOW_DIAGONAL, -FLOW_DIAGONAL, FLOW_DIAGONAL};
+
+void update_flow_field(flow_field &field, const point_2d &target)
+{
+    int tx = (int)floor((target.x - field.left) / field.cell), ty = (int)floor((target.y - field.top) / field.cell);
+    int target_cell = tx >= 0 and ty >= 0 and tx < field.columns and ty < field.rows ? ty * field.columns + tx : -1;
+
+    // a target going back and forth over the edge of a cell does not search every time, it has to leave
+    // the cells around the last search first. foes that close head straight for it anyway
+    if (target_cell >= 0 and field.target_cell >= 0 and abs(tx - field.target_cell % field.columns) <= 1 and abs(ty - field.target_cell / field.columns) <= 1)
+        return;
+    field.target_cell = target_cell;
+
+    fill(field.steps.begin(), field.steps.end(), FLOW_UNREACHABLE);
+    fill(field.way.begin(), field.way.end(), FLOW_STRAIGHT);
+
+    // off the grid everything heads straight for the target
+    if (target_cell < 0)
+        return;
+
+    field.frontier.clear();
+    field.frontier.push_back(target_cell);
+    field.steps[target_cell] = 0;
+
+    // the frontier is the queue of the search, read from the front as it grows.
+    // a cell is reached first from a cell one step closer, so the way back to it is on a shortest path
+    for (size_t next = 0; next < field.frontier.size(); next++)
+    {
+        int cell = field.frontier[next];
+        int cx = cell % field.columns, cy = cell / field.columns;
+
+        for (int n = 0; n < 8; n++)
+        {
+            int nx = cx + FLOW_NEIGHBOUR_X[n], ny = cy + FLOW_NEIGHBOUR_Y[n];
+            if (nx < 0 or ny < 0 or nx >= field.columns or ny >= field.rows)
+                continue;
+
+            int neighbour = ny * field.columns + nx;
+            if (field.blocked[neighbour] or field.steps[neighbour] != FLOW_UNREACHABLE)
+                continue;
+
+            field.steps[neighbour] = field.steps[cell] + 1;
+            field.way[neighbour] = n ^ 1;
+            field.frontier.push_back(neighbour);
+        }
+    }
+}
+
+void gather_crowd(flow_field &field, const spatial_index &index)
+{
+    size_t cells = (size_t)index.columns * index.rows;
+    field.crowd.assign(cells, 0);
+    field.crowd_x.assign(cells, 0);
+    field.crowd_y.assign(cells, 0);
+
+    // the entries are sorted by cell, so this is one pass through the grid
+    for (size_t cell = 0; cell < cells; cell++)
+    {
+        for (uint32_t i = index.cell_start[cell]; i < index.cell_start[cell + 1]; i++)
+        {
+            const spatial_entry &entry = index.entries[i];
+            if (not spatial_matches(index, entry.ref, HOSTILE))
+                continue;
+
+            field.crowd[cell]++;
+            field.crowd_x[cell] += entry.x;
+            field.crowd_y[cell] += entry.y;
+        }
+    }
+}
+
+/**
+ * how hard the foes in the cells around a foe push it away. the foes of
+ * a cell push together from their middle, harder the more of them there are.
+ * a foe that is in the grid is taken out of its own cell first
+ */
+void crowd_push(const flow_field &field, const spatial_index &index, float x, float y, bool in_grid, float &push_x, float &push_y)
+{
+    push_x = push_y = 0;
+    if (index.columns == 0)
+        return;
+
+    int own_x = spatial_cell(x, index.min_x, index.cell_size), own_y = spatial_cell(y, index.min_y, index.cell_size);
+
+    for (int cy = max(0, own_y - 1); cy <= min(index.rows - 1, own_y + 1); cy++)
+    {
+        for (int cx = max(0, own_x - 1); cx <= min(index.columns - 1, own_x + 1); cx++)
+        {
+            size_t cell = (size_t)cy * index.columns + cx;
+            float count = field.crowd[cell], sum_x = field.crowd_x[cell], sum_y = field.crowd_y[cell];
+
+            // a foe does not push itself. foes that spawned or woke up since the grid was built are not in it
+            if (in_grid and cx == own_x and cy == own_y and count > 0)
+            {
+                count--;
+                sum_x -= x;
+                sum_y -= y;
+            }
+            if (count == 0)
+                continue;
+
+            float dx = x - sum_x / count, dy = y - sum_y / count;
+            float dist_sq = dx * dx + dy * dy;
+            if (dist_sq >= FOE_SEPARATION * FOE_SEPARATION or dist_sq == 0)
+                continue;
+
+            float dist = sqrt(dist_sq);
+            float strength = count * (FOE_SEPARATION - dist) / (FOE_SEPARATION * dist);
+            push_x += dx * strength;
+            push_y += dy * strength;
+        }
+    }
+}
+
+void steer_foes(entity_store &entities, size_t archetype, const flow_field &field, const spatial_index &index, const point_2d &target)
+{
+    for (size_t num = 0; num < entity_count(entities); num++)
+    {
+        if (entities.interval[num] == 0 or entities.dead[num])
+            continue;
+
+        float x = entities.x[num] + entities.width[num] / 2, y = entities.y[num] + entities.height[num] / 2;
+        int cx = (int)floor((x - field.left) / field.cell), cy = (int)floor((y - field.top) / field.cell);
+        float want_x = 0, want_y = 0;
+
+        int cell = cx >= 0 and cy >= 0 and cx < field.columns and cy < field.rows ? cy * field.columns + cx : -1;
+        int way = cell >= 0 and field.steps[cell] > 1 ? field.way[cell] : FLOW_STRAIGHT;
+        if (way != FLOW_STRAIGHT)
+        {
+            want_x = FLOW_WAY_X[way];
+            want_y = FLOW_WAY_Y[way];
+        }
+        else
+        {
+            // next to the target, off the field or cut off, the target is right there or there is no better way
+            float dx = target.x - x, dy = target.y - y;
+            float length = sqrt(dx * dx + dy * dy);
+            if (length > 0)
+            {
+                want_x = dx / length;
+                want_y = dy / length;
+            }
+        }
+
+        float push_x, push_y;
+        crowd_push(field, index, x, y, spatial_holds(index, archetype, num), push_x, push_y);
+
+        entities.dx[num] += (want_x * FOE_HUNT_SPEED - entities.dx[num]) * FOE_STEER + push_x * FOE_SEPARATION_WEIGHT;
+        entities.dy[num] += (want_y * FOE_HUNT_SPEED - entities.dy[num]) * FOE_STEER + push_y * FOE_SEPARATION_WEIGHT;
+    }
+}
+
+void run_swarm_benchmark(int count)
+{
+    // the foes are spread out about SWARM_BENCH_SPACING apart, with the target in the middle
+    int cells = (int)ceil(sqrt((double)count) * SWARM_BENCH_SPACING / SWARM_BENCH_CELL);
+    float side = (float)cells * SWARM_BENCH_CELL;
+
+    entity_registry registry;
+    registry.next_id = 1;
+    registry.static_changes = 0;
+    game_rng rng = new_rng(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        spawn_into(registry, entity_spawn(FOE, rng_float(rng) * side, rng_float(rng) * side, rng));
+    }
+
+    // about as many planets for the area as the world has
+    vector<gravity_body> planets;
+    int planet_count = (int)(GRAVITY_PLANET_CHANCE * side * side / ((float)CHUNK_SIZE * CHUNK_SIZE));
+    for (int i = 0; i < planet_count; i++)
+    {
+        planet_kind kind = (planet_kind)rng_int(rng, 0, PLANET_KIND_COUNT);
+        planets.push_back({rng_float(rng) * side, rng_float(rng) * side, PLANET_ARCHETYPES[kind].mass, PLANET_ARCHETYPES[kind].radius, kind});
+    }
+
+    // the swarm spreads over many chunks, so its field is coarser than the game's
+    flow_field field = new_flow_field(cells, cells, SWARM_BENCH_CELL);
+    place_flow_field(field, 0, 0, planets);
+    spatial_index index;
+
+    double budget_ms = 1000.0 / 60;
+    double flow_ms = 0, steer_ms = 0, move_ms = 0, grid_ms = 0, worst_ms = 0;
+    int searches = 0, late = 0;
+
+    for (int tick = 1; tick <= SWARM_BENCH_TICKS; tick++)
+    {
+        // the target circles the middle at the player's top speed
+        float angle = tick * MAX_VEL / (side / 4);
+        point_2d target = point_at(side / 2 + cos(angle) * side / 4, side / 2 + sin(angle) * side / 4);
+
+        auto start = chrono::steady_clock::now();
+        int before = field.target_cell;
+        update_flow_field(field, target);
+        searches += field.target_cell != before;
+        gather_crowd(field, index);
+        auto flowed = chrono::steady_clock::now();
+
+        for (size_t a = 0; a < registry.archetypes.size(); a++)
+        {
+            steer_foes(registry.archetypes[a].entities, a, field, index, target);
+        }
+        auto steered = chrono::steady_clock::now();
+
+        for (size_t a = 0; a < registry.archetypes.size(); a++)
+        {
+            update_entities(registry.archetypes[a].entities, tick);
+        }
+        auto moved = chrono::steady_clock::now();
+
+        build_spatial_index(index, registry, 0, 0);
+        auto built = chrono::steady_clock::now();
+
+        flow_ms += chrono::duration<double, milli>(flowed - start).count();
+        steer_ms += chrono::duration<double, milli>(steered - flowed).count();
+        move_ms += chrono::duration<double, milli>(moved - steered).count();
+        grid_ms += chrono::duration<double, milli>(built - moved).count();
+        double tick_ms = chrono::duration<double, milli>(built - start).count();
+        worst_ms = max(worst_ms, tick_ms);
+        late += tick_ms > budget_ms;
+    }
+
+    double total_ms = (flow_ms + steer_ms + move_ms + grid_ms) / SWARM_BENCH_TICKS;
+    write_line(to_string(count) + " foes on a " + to_string(cells) + "x" + to_string(cells) + " field around " + to_string(planet_count) + " planets, " + to_string(searches) + " searches in " + to_string(SWARM_BENCH_TICKS) + " updates");
+    write_line("per update: field " + to_string(flow_ms / SWARM_BENCH_TICKS) + " ms, steering " + to_string(steer_ms / SWARM_BENCH_TICKS) + " ms, moving " + to_string(move_ms / SWARM_BENCH_TICKS) + " ms, neighbour grid " + to_string(grid_ms / SWARM_BENCH_TICKS) + " ms");
+    write_line("total " + to_string(total_ms) + " ms, worst " + to_string(worst_ms) + " ms, " + to_string(late) + " updates over the 60 Hz budget");
+}
+
+//                                      ●▬▬▬▬   »»»       flock.𝗵       «««  ▬▬▬▬▬●
+
+#define FLOCK_RADIUS 150
+#define FLOCK_SEPARATION 100
+#define FLOCK_COHESION 0.003f
+#define FLOCK_ALIGNMENT 0.05f
+#define FLOCK_AVOIDANCE 0.06f
+#define FLOCK_MIN_SPEED 0.5f
+#define FLOCK_MAX_SPEED 1.6f
+#define FLOCK_SEEK 0.02f
+#define FLOCK_CELLS_PER_AGENT 4
+#define FLOCK_PARALLEL_MIN 4096
+#define FLOCK_BENCH_TICKS 60
+#define FLOCK_BENCH_SPACING 50
+#define SWARM_FOES 2000
+#define SWARM_MIN_DISTANCE 800
+
+/**
+ * The flock keeps a copy of the agents sorted by the cell they are in, so
+ * an agent's neighbours sit in three runs next to each other in memory, one
+ * per row of cells around it. Each run is added up with SIMD, and the agents
+ * are split over threads. Every agent reads the same sorted copy and writes
+ * only its own new velocity, so the flock moves the same on any number of threads.
+ * 
+ * @field   min_x, min_y    world position of the top left of the grid
+ * @field   cell_size       width and height of a cell, never less than FLOCK_RADIUS
+ * @field   columns, rows   size of the grid in cells
+ * @field   cell_start      where each cell starts in the sorted agents, with one extra at the end
+ * @field   cell_of         the cell of each agent, in the entity store's order, unused for dead agents
+ * @field   order           the entity store index of each sorted agent, dead agents are not sorted
+ * @field   x, y            centres of the sorted agents
+ * @field   vx, vy          velocities of the sorted agents
+ * @field   new_vx, new_vy  velocities worked out for the sorted agents
+ */
+struct flock_data
+{
+    float min_x, min_y;
+    float cell_size;
+    int columns, rows;
+    vector<uint32_t> cell_start;
+    vector<uint32_t> cell_of;
+    vector<uint32_t> order;
+    vector<float> x, y;
+    vector<float> vx, vy;
+    vector<float> new_vx, new_vy;
+};
+
+/**
+ * Creates an empty flock.
+ */
+flock_data new_flock();
+
+/**
+ * Turns every agent of an entity store a little towards the middle and the
+ * heading of the agents around it and away from the ones too close, and
+ * keeps its speed between FLOCK_MIN_SPEED and FLOCK_MAX_SPEED. Sleeping
+ * agents still count as neighbours, but their own velocities are left alone.
+ * Dead agents, like foes shot since the dead were last removed, are left out.
+ * 
+ * @param flock     the flock's reused lists
+ * @param entities  the agents
+ * @param target    what the flock is drawn to
+ * @param seek      how hard the flock is drawn to the target, 0 to ignore it
+ * @param pool      threads to split the agents over, nullptr for one
+ */
+void flock_entities(flock_data &flock, entity_store &entities, const point_2d &target, float seek, worker_pool *pool);
+
+/**
+ * Flocks count agents spread FLOCK_BENCH_SPACING apart and times each
+ * update against the 60 Hz frame budget.
+ * 
+ * @param count     agents in the flock
+ * @param threads   most threads to flock on, 0 for one per core
+ */
+void run_flock_benchmark(int count, int threads);
+
+//                                      ●▬▬▬▬   »»»       flock.cpp       «««  ▬▬▬▬▬●
+
+flock_data new_flock()
+{
+    flock_data result;
+    result.min_x = result.min_y = 0;
+    result.cell_size = FLOCK_RADIUS;
+    result.columns = result.rows = 0;
+    return result;
+}
+
+/**
+ * The neighbours of one agent added up.
+ * 
+ * @field   count           neighbours within FLOCK_RADIUS
+ * @field   to_x, to_y      offsets from the agent to those neighbours, added up
+ * @field   vx, vy          velocities of those neighbours, added up
+ * @field   away_x, away_y  pushes away from the neighbours within FLOCK_SEPARATION
+ */
+struct flock_sums
+{
+    float count;
+    float to_x, to_y;
+    float vx, vy;
+    float away_x, away_y;
+};
+
+#if defined(__AVX__)
+float lane_sum(__m256 lanes)
+{
+    alignas(32) float values[8];
+    _mm256_store_ps(values, lanes);
+    return ((values[0] + values[1]) + (values[2] + values[3])) + ((values[4] + values[5]) + (values[6] + values[7]));
+}
+#endif
+#if defined(__SSE2__)
+float lane_sum(__m128 lanes)
+{
+    alignas(16) float values[4];
+    _mm_store_ps(values, lanes);
+    return (values[0] + values[1]) + (values[2] + values[3]);
+}
+#endif
+
+/**
+ * adds up the agents in one run of the sorted lists around an agent at (x, y),
+ * eight at a time with AVX or four at a time with SSE. the agent itself is
+ * in one of the runs, it is left out as it is at distance 0
+ */
+void add_neighbours(const flock_data &flock, uint32_t first, uint32_t last, float x, float y, flock_sums &sums)
+{
+    const float *xs = flock.x.data(), *ys = flock.y.data(), *vxs = flock.vx.data(), *vys = flock.vy.data();
+    const float radius_sq = FLOCK_RADIUS * FLOCK_RADIUS, separation_sq = FLOCK_SEPARATION * FLOCK_SEPARATION;
+    uint32_t i = first;
+
+#if defined(__AVX__)
+    if (i + 8 <= last)
+    {
+        __m256 x8 = _mm256_set1_ps(x), y8 = _mm256_set1_ps(y), zero8 = _mm256_setzero_ps(), one8 = _mm256_set1_ps(1);
+        __m256 radius8 = _mm256_set1_ps(radius_sq), separation8 = _mm256_set1_ps(separation_sq);
+        __m256 count = zero8, to_x = zero8, to_y = zero8, vx = zero8, vy = zero8, away_x = zero8, away_y = zero8;
+
+        for (; i + 8 <= last; i += 8)
+        {
+            __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs + i), x8), dy = _mm256_sub_ps(_mm256_loadu_ps(ys + i), y8);
+            __m256 dist_sq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            __m256 other = _mm256_cmp_ps(dist_sq, zero8, _CMP_GT_OQ);
+            __m256 near = _mm256_and_ps(_mm256_cmp_ps(dist_sq, radius8, _CMP_LT_OQ), other);
+            __m256 close = _mm256_and_ps(_mm256_cmp_ps(dist_sq, separation8, _CMP_LT_OQ), other);
+
+            count = _mm256_add_ps(count, _mm256_and_ps(near, one8));
+            to_x = _mm256_add_ps(to_x, _mm256_and_ps(near, dx));
+            to_y = _mm256_add_ps(to_y, _mm256_and_ps(near, dy));
+            vx = _mm256_add_ps(vx, _mm256_and_ps(near, _mm256_loadu_ps(vxs + i)));
+            vy = _mm256_add_ps(vy, _mm256_and_ps(near, _mm256_loadu_ps(vys + i)));
+
+            // the agent itself is at distance 0, the mask drops the division by it
+            __m256 push = _mm256_and_ps(close, _mm256_div_ps(one8, _mm256_max_ps(dist_sq, one8)));
+            away_x = _mm256_sub_ps(away_x, _mm256_mul_ps(dx, push));
+            away_y = _mm256_sub_ps(away_y, _mm256_mul_ps(dy, push));
+        }
+
+        sums.count += lane_sum(count);
+        sums.to_x += lane_sum(to_x);
+        sums.to_y += lane_sum(to_y);
+        sums.vx += lane_sum(vx);
+        sums.vy += lane_sum(vy);
+        sums.away_x += lane_sum(away_x);
+        sums.away_y += lane_sum(away_y);
+    }
+#endif
+#if defined(__SSE2__)
+    if (i + 4 <= last)
+    {
+        __m128 x4 = _mm_set1_ps(x), y4 = _mm_set1_ps(y), zero4 = _mm_setzero_ps(), one4 = _mm_set1_ps(1);
+        __m128 radius4 = _mm_set1_ps(radius_sq), separation4 = _mm_set1_ps(separation_sq);
+        __m128 count = zero4, to_x = zero4, to_y = zero4, vx = zero4, vy = zero4, away_x = zero4, away_y = zero4;
+
+        for (; i + 4 <= last; i += 4)
+        {
+            __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), x4), dy = _mm_sub_ps(_mm_loadu_ps(ys + i), y4);
+            __m128 dist_sq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            __m128 other = _mm_cmpgt_ps(dist_sq, zero4);
+            __m128 near = _mm_and_ps(_mm_cmplt_ps(dist_sq, radius4), other);
+            __m128 close = _mm_and_ps(_mm_cmplt_ps(dist_sq, separation4), other);
+
+            count = _mm_add_ps(count, _mm_and_ps(near, one4));
+            to_x = _mm_add_ps(to_x, _mm_and_ps(near, dx));
+            to_y = _mm_add_ps(to_y, _mm_and_ps(near, dy));
+            vx = _mm_add_ps(vx, _mm_and_ps(near, _mm_loadu_ps(vxs + i)));
+            vy = _mm_add_ps(vy, _mm_and_ps(near, _mm_loadu_ps(vys + i)));
+
+            __m128 push = _mm_and_ps(close, _mm_div_ps(one4, _mm_max_ps(dist_sq, one4)));
+            away_x = _mm_sub_ps(away_x, _mm_mul_ps(dx, push));
+            away_y = _mm_sub_ps(away_y, _mm_mul_ps(dy, push));
+        }
+
+        sums.count += lane_sum(count);
+        sums.to_x += lane_sum(to_x);
+        sums.to_y += lane_sum(to_y);
+        sums.vx += lane_sum(vx);
+        sums.vy += lane_sum(vy);
+        sums.away_x += lane_sum(away_x);
+        sums.away_y += lane_sum(away_y);
+    }
+#endif
+
+    for (; i < last; i++)
+    {
+        float dx = xs[i] - x, dy = ys[i] - y;
+        float dist_sq = dx * dx + dy * dy;
+        if (dist_sq == 0 or dist_sq >= radius_sq)
+            continue;
+
+        sums.count += 1;
+        sums.to_x += dx;
+        sums.to_y += dy;
+        sums.vx += vxs[i];
+        sums.vy += vys[i];
+
+        if (dist_sq < separation_sq)
+        {
+            float push = 1 / max(dist_sq, 1.0f);
+            sums.away_x -= dx * push;
+            sums.away_y -= dy * push;
+        }
+    }
+}
+
+/**
+ * works out the new velocities of the sorted agents from first to last
+ */
+void flock_range(flock_data &flock, size_t first, size_t last, float target_x, float target_y, float seek)
+{
+    for (size_t i = first; i < last; i++)
+    {
+        float x = flock.x[i], y = flock.y[i];
+        int cx = (int)((x - flock.min_x) / flock.cell_size), cy = (int)((y - flock.min_y) / flock.cell_size);
+        int left = max(0, cx - 1), right = min(flock.columns - 1, cx + 1);
+
+        // the three cells of a row are next to each other in the sorted lists
+        flock_sums sums = {0, 0, 0, 0, 0, 0, 0};
+        for (int row = max(0, cy - 1); row <= min(flock.rows - 1, cy + 1); row++)
+        {
+            size_t start = (size_t)row * flock.columns;
+            add_neighbours(flock, flock.cell_start[start + left], flock.cell_start[start + right + 1], x, y, sums);
+        }
+
+        float vx = flock.vx[i], vy = flock.vy[i];
+        if (sums.count > 0)
+        {
+            vx += sums.to_x / sums.count * FLOCK_COHESION + (sums.vx / sums.count - vx) * FLOCK_ALIGNMENT;
+            vy += sums.to_y / sums.count * FLOCK_COHESION + (sums.vy / sums.count - vy) * FLOCK_ALIGNMENT;
+        }
+
+        // the pushes are 1 / distance long, so a neighbour right at FLOCK_SEPARATION pushes with FLOCK_AVOIDANCE
+        vx += sums.away_x * FLOCK_SEPARATION * FLOCK_AVOIDANCE;
+        vy += sums.away_y * FLOCK_SEPARATION * FLOCK_AVOIDANCE;
+
+        float tx = target_x - x, ty = target_y - y;
+        float target_dist = sqrt(tx * tx + ty * ty);
+        if (seek > 0 and target_dist > 0)
+        {
+            vx += tx / target_dist * seek;
+            vy += ty / target_dist * seek;
+        }
+
+        float speed = sqrt(vx * vx + vy * vy);
+        float limited = clamp(speed, FLOCK_MIN_SPEED, FLOCK_MAX_SPEED);
+        if (speed > 0)
+        {
+            vx *= limited / speed;
+            vy *= limited / speed;
+        }
+
+        flock.new_vx[i] = vx;
+        flock.new_vy[i] = vy;
+    }
+}
+
+/**
+ * sorts the live agents by cell into the flock's lists with a counting sort
+ */
+void sort_flock(flock_data &flock, const entity_store &entities)
+{
+    size_t count = entity_count(entities);
+    size_t live = 0;
+    float min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (entities.dead[i])
+            continue;
+
+        live++;
+        float x = entities.x[i] + entities.width[i] / 2, y = entities.y[i] + entities.height[i] / 2;
+        min_x = min(min_x, x);
+        min_y = min(min_y, y);
+        max_x = max(max_x, x);
+        max_y = max(max_y, y);
+    }
+
+    flock.order.resize(live);
+    if (live == 0)
+        return;
+
+    // a thin flock spread far gets bigger cells so the grid is never much bigger than the flock
+    float width = max_x - min_x, height = max_y - min_y;
+    flock.cell_size = max((float)FLOCK_RADIUS, sqrt(width * height / (live * FLOCK_CELLS_PER_AGENT)));
+    flock.min_x = min_x;
+    flock.min_y = min_y;
+    flock.columns = (int)(width / flock.cell_size) + 1;
+    flock.rows = (int)(height / flock.cell_size) + 1;
+
+    size_t cells = (size_t)flock.columns * flock.rows;
+    flock.cell_start.assign(cells + 1, 0);
+    flock.cell_of.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (entities.dead[i])
+            continue;
+
+        int cx = (int)((entities.x[i] + entities.width[i] / 2 - min_x) / flock.cell_size);
+        int cy = (int)((entities.y[i] + entities.height[i] / 2 - min_y) / flock.cell_size);
+        flock.cell_of[i] = min(cy, flock.rows - 1) * flock.columns + min(cx, flock.columns - 1);
+        flock.cell_start[flock.cell_of[i] + 1]++;
+    }
+    for (size_t c = 0; c < cells; c++)
+    {
+        flock.cell_start[c + 1] += flock.cell_start[c];
+    }
+
+    flock.x.resize(live);
+    flock.y.resize(live);
+    flock.vx.resize(live);
+    flock.vy.resize(live);
+    flock.new_vx.resize(live);
+    flock.new_vy.resize(live);
+
+    // cell_start is moved along while placing and put back after, saving a second list
+    for (size_t i = 0; i < count; i++)
+    {
+        if (entities.dead[i])
+            continue;
+
+        uint32_t slot = flock.cell_start[flock.cell_of[i]]++;
+        flock.order[slot] = i;
+        flock.x[slot] = entities.x[i] + entities.width[i] / 2;
+        flock.y[slot] = entities.y[i] + entities.height[i] / 2;
+        flock.vx[slot] = entities.dx[i];
+        flock.vy[slot] = entities.dy[i];
+    }
+    for (size_t c = cells; c > 0; c--)
+    {
+        flock.cell_start[c] = flock.cell_start[c - 1];
+    }
+    flock.cell_start[0] = 0;
+}
+
+void flock_entities(flock_data &flock, entity_store &entities, const point_2d &target, float seek, worker_pool *pool)
+{
+    sort_flock(flock, entities);
+
+    size_t count = flock.order.size();
+    if (count == 0)
+        return;
+
+    // a small flock updates faster than the work is handed out
+    size_t shares = max((size_t)1, min(pool_threads(pool), count / FLOCK_PARALLEL_MIN));
+    size_t per_share = (count + shares - 1) / shares;
+
+    run_on_pool(pool, shares, [&](size_t t)
+    {
+        flock_range(flock, t * per_share, min(count, (t + 1) * per_share), target.x, target.y, seek);
+    });
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t num = flock.order[i];
+        if (entities.interval[num] == 0)
+            continue;
+
+        entities.dx[num] = flock.new_vx[i];
+        entities.dy[num] = flock.new_vy[i];
+    }
+}
+
+void run_flock_benchmark(int count, int threads)
+{
+    float side = sqrt((float)count) * FLOCK_BENCH_SPACING;
+    game_rng rng = new_rng(count);
+
+    entity_store entities;
+    for (int i = 0; i < count; i++)
+    {
+        add_entity(entities, entity_spawn(FOE, rng_float(rng) * side, rng_float(rng) * side, rng), i + 1);
+    }
+
+    flock_data flock = new_flock();
+    worker_pool *pool = new_worker_pool(threads);
+    point_2d centre = point_at(side / 2, side / 2);
+    double total_ms = 0, worst_ms = 0;
+
+    for (int tick = 1; tick <= FLOCK_BENCH_TICKS; tick++)
+    {
+        auto start = chrono::steady_clock::now();
+        flock_entities(flock, entities, centre, 0, pool);
+        update_entities(entities, tick);
+        double tick_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        total_ms += tick_ms;
+        worst_ms = max(worst_ms, tick_ms);
+    }
+
+    double budget_ms = 1000.0 / 60;
+    int used = max(1, min((int)pool_threads(pool), count / FLOCK_PARALLEL_MIN));
+    free_worker_pool(pool);
+    write_line(to_string(count) + " agents, " + to_string(used) + " threads: " + to_string(total_ms / FLOCK_BENCH_TICKS) + " ms per update, worst " + to_string(worst_ms) + " ms, " + to_string(100 * total_ms / FLOCK_BENCH_TICKS / budget_ms) + "% of the 60 Hz budget");
+}
+
+//                                      ●▬▬▬▬   »»»       starfield.𝗵       «««  ▬▬▬▬▬●
+
+#define STAR_LAYERS 3
+#define STAR_TILE_SIZE 256
+#define STAR_TILE_POOL 64
+
+/**
+ * A tile of stars that was rendered into its own bitmap.
+ * 
+ * @field   bmp         the bitmap holding the rendered stars
+ * @field   last_used   the frame on which the tile was last drawn
+ */
+struct star_tile
+{
+    bitmap bmp;
+    unsigned int last_used;
+};
+
+/**
+ * The starfield keeps the rendered tiles of every parallax layer.
+ * Tiles are only generated when they first come on screen and their
+ * bitmaps are reused once they scroll away.
+ * 
+ * @field   tiles       the rendered tiles of each layer by tile id
+ * @field   free_tiles  bitmaps of tiles that went off screen, ready for reuse
+ * @field   frame       counts the frames the starfield was drawn
+ * @field   created     number of tile bitmaps made so far (used for their names)
+ */
+struct starfield_data
+{
+    unordered_map<long long, star_tile> tiles[STAR_LAYERS];
+    vector<bitmap> free_tiles;
+    unsigned int frame;
+    int created;
+};
+
+/**
+ * Creates a starfield with no rendered tiles.
+ */
+starfield_data new_starfield();
+
+/**
+ * Draws every layer of the starfield behind the game, moving each layer
+ * slower than the camera so the far stars look further away.
+ * 
+ * @param stars     the starfield to draw
+ */
+void draw_starfield(starfield_data &stars);
+
+/**
+ * Frees every tile bitmap of the starfield.
+ * 
+ * @param stars     the starfield to free
+ */
+void free_starfield(starfield_data &stars);
+
+//                                      ●▬▬▬▬   »»»       starfield.cpp       «««  ▬▬▬▬▬●
+
+// how much each layer moves with the camera, the furthest layer first
+const double STAR_PARALLAX[STAR_LAYERS] = {0.15, 0.4, 0.75};
+// number of stars in one tile of each layer
+const int STAR_COUNT[STAR_LAYERS] = {60, 18, 6};
+// largest star radius of each layer
+const double STAR_RADIUS[STAR_LAYERS] = {0.8, 1.3, 2.0};
+
+/**
+ * Mixes the bits of a number so that nearby tiles get unrelated stars.
+ * (the splitmix64 finaliser)
+ */
+uint64_t star_hash(uint64_t value)
+{
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+/**
+ * Gives the next number between 0 and 1 from a tile's random state.
+ */
+double star_random(uint64_t &state)
+{
+    state = star_hash(state);
+    return (state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * Draws the stars of a tile into its bitmap.
+ * The same layer and tile always get the same stars.
+ */
+void render_star_tile(bitmap bmp, int layer, long long id)
+{
+    uint64_t state = star_hash((uint64_t)id ^ ((uint64_t)layer << 61));
+
+    clear_bitmap(bmp, COLOR_TRANSPARENT);
+
+    for (int i = 0; i < STAR_COUNT[layer]; i++)
+    {
+        double x = star_random(state) * STAR_TILE_SIZE;
+        double y = star_random(state) * STAR_TILE_SIZE;
+        double radius = 0.4 + star_random(state) * STAR_RADIUS[layer];
+        int brightness = 90 + (int)(star_random(state) * 165);
+
+        // a few stars get a slight blue or orange tint
+        double tint = star_random(state);
+        int red = tint < 0.1 ? brightness * 3 / 4 : brightness;
+        int blue = tint > 0.9 ? brightness * 3 / 4 : brightness;
+
+        fill_circle_on_bitmap(bmp, rgba_color(red, brightness, blue, 255), x, y, radius);
+    }
+}
+
+/**
+ * Finds the rendered tile, rendering it into a free bitmap if it is not cached.
+ */
+bitmap star_tile_bitmap(starfield_data &stars, int layer, int tx, int ty)
+{
+    long long id = chunk_id(tx, ty);
+
+    auto found = stars.tiles[layer].find(id);
+    if (found == stars.tiles[layer].end())
+    {
+        star_tile tile;
+
+        if (stars.free_tiles.empty())
+        {
+            tile.bmp = create_bitmap("star_tile_" + to_string(stars.created++), STAR_TILE_SIZE, STAR_TILE_SIZE);
+            live_resources.bitmaps++;
+        }
+        else
+        {
+            tile.bmp = stars.free_tiles.back();
+            stars.free_tiles.pop_back();
+        }
+
+        render_star_tile(tile.bmp, layer, id);
+        found = stars.tiles[layer].emplace(id, tile).first;
+    }
+
+    found->second.last_used = stars.frame;
+    return found->second.bmp;
+}
+
+starfield_data new_starfield()
+{
+    starfield_data result;
+    result.frame = 0;
+    result.created = 0;
+    return result;
+}
+
+void draw_starfield(starfield_data &stars)
+{
+    stars.frame++;
+
+    for (int layer = 0; layer < STAR_LAYERS; layer++)
+    {
+        double layer_x = camera_x() * STAR_PARALLAX[layer];
+        double layer_y = camera_y() * STAR_PARALLAX[layer];
+
+        int first_x = (int)floor(layer_x / STAR_TILE_SIZE);
+        int first_y = (int)floor(layer_y / STAR_TILE_SIZE);
+        int last_x = (int)floor((layer_x + screen_width()) / STAR_TILE_SIZE);
+        int last_y = (int)floor((layer_y + screen_height()) / STAR_TILE_SIZE);
+
+        for (int tx = first_x; tx <= last_x; tx++)
+        {
+            for (int ty = first_y; ty <= last_y; ty++)
+            {
+                bitmap bmp = star_tile_bitmap(stars, layer, tx, ty);
+                draw_bitmap(bmp, (double)tx * STAR_TILE_SIZE - layer_x, (double)ty * STAR_TILE_SIZE - layer_y, option_to_screen());
+            }
+        }
+
+        // tiles that were not drawn this frame have scrolled away, keep their bitmaps for new tiles
+        for (auto it = stars.tiles[layer].begin(); it != stars.tiles[layer].end();)
+        {
+            if (it->second.last_used == stars.frame)
+            {
+                it++;
+                continue;
+            }
+
+            if (stars.free_tiles.size() < STAR_TILE_POOL)
+                stars.free_tiles.push_back(it->second.bmp);
+            else
+            {
+                free_bitmap(it->second.bmp);
+                live_resources.bitmaps--;
+            }
+
+            it = stars.tiles[layer].erase(it);
+        }
+    }
+}
+
+void free_starfield(starfield_data &stars)
+{
+    for (int layer = 0; layer < STAR_LAYERS; layer++)
+    {
+        for (auto &tile : stars.tiles[layer])
+        {
+            free_bitmap(tile.second.bmp);
+            live_resources.bitmaps--;
+        }
+        stars.tiles[layer].clear();
+    }
+
+    for (size_t i = 0; i < stars.free_tiles.size(); i++)
+    {
+        free_bitmap(stars.free_tiles[i]);
+        live_resources.bitmaps--;
+    }
+    stars.free_tiles.clear();
+}
+
+//                                      ●▬▬▬▬   »»»       timer_wheel.𝗵       «««  ▬▬▬▬▬●
+
+#define TICKS_PER_SECOND 60
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 4
+
+/**
+ * The kinds of events that can be scheduled on the timer wheel.
+ */
+enum timer_kind
+{
+    SPAWN_EVENT,            // time for the next entity to spawn near the player
+    SHIELD_EXPIRY_EVENT,    // the player's shield runs out
+    DESPAWN_EVENT           // an entity disappears
+};
+
+/**
+ * An event waiting on the timer wheel.
+ * 
+ * @field   due         the tick the event happens on
+ * @field   kind        what happens
+ * @field   payload     extra detail for the event, like the id of the entity to despawn
+ */
+struct timer_event
+{
+    unsigned long long due;
+    timer_kind kind;
+    unsigned int payload;
+};
+
+/**
+ * A hierarchical timer wheel counting simulation ticks. Level 0 has a slot
+ * for each of the next 64 ticks, every level above covers 64 times as long
+ * and is moved down a level when its slot comes up. Scheduling and firing
+ * an event costs the same no matter how many events are waiting.
+ * 
+ * @field   now         the current tick
+ * @field   slots       the events waiting in each slot of each level
+ * @field   pending     number of events waiting
+ */
+struct timer_wheel
+{
+    unsigned long long now;
+    vector<timer_event> slots[WHEEL_LEVELS][WHEEL_SLOTS];
+    size_t pending;
+};
+
+/**
+ * Creates an empty timer wheel at tick 0.
+ */
+timer_wheel new_timer_wheel();
+
+/**
+ * Schedules an event a number of ticks from now (at least one).
+ * 
+ * @param wheel     the wheel to schedule on
+ * @param delay     ticks from now
+ * @param kind      what happens
+ * @param payload   extra detail for the event
+ */
+void schedule_event(timer_wheel &wheel, unsigned long long delay, timer_kind kind, unsigned int payload);
+
+/**
+ * Moves the wheel on by one tick.
+ * 
+ * @param wheel     the wheel to move
+ * @param fired     the events due on the new tick are added to this
+ */
+void advance_timer_wheel(timer_wheel &wheel, vector<timer_event> &fired);
+
+/**
+ * Drops every event still waiting on the wheel.
+ * 
+ * @param wheel     the wheel to empty
+ */
+void free_timer_wheel(timer_wheel &wheel);
+
+/**
+ * Converts seconds of game time into ticks.
+ */
+unsigned long long seconds_to_ticks(double seconds);
+
+//                                      ●▬▬▬▬   »»»       timer_wheel.cpp       «««  ▬▬▬▬▬●
+
+timer_wheel new_timer_wheel()
+{
+    timer_wheel result;
+    result.now = 0;
+    result.pending = 0;
+    return result;
+}
+
+unsigned long long seconds_to_ticks(double seconds)
+{
+    return (unsigned long long)ceil(seconds * TICKS_PER_SECOND);
+}
+
+/**
+ * Puts an event in the slot for its due tick, on the lowest level
+ * that reaches that far. Events too far away wait on the top level.
+ */
+void place_event(timer_wheel &wheel, const timer_event &event)
+{
+    unsigned long long delta = event.due - wheel.now;
+    int level = 0;
+
+    while (level < WHEEL_LEVELS - 1 and delta >= (1ULL << (WHEEL_BITS * (level + 1))))
+    {
+        level++;
+    }
+
+    int slot = (event.due >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1);
+    wheel.slots[level][slot].push_back(event);
+}
+
+void schedule_event(timer_wheel &wheel, unsigned long long delay, timer_kind kind, unsigned int payload)
+{
+    timer_event event;
+    event.due = wheel.now + max(1ULL, delay);
+    event.kind = kind;
+    event.payload = payload;
+
+    place_event(wheel, event);
+    wheel.pending++;
+    live_resources.timers++;
+}
+
+void advance_timer_wheel(timer_wheel &wheel, vector<timer_event> &fired)
+{
+    wheel.now++;
+
+    // when a level comes round to the start, the next slot of the level above moves down
+    for (int level = WHEEL_LEVELS - 1; level > 0; level--)
+    {
+        if ((wheel.now & ((1ULL << (WHEEL_BITS * level)) - 1)) != 0)
+            continue;
+
+        int slot = (wheel.now >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1);
+        vector<timer_event> moving;
+        moving.swap(wheel.slots[level][slot]);
+
+        for (size_t i = 0; i < moving.size(); i++)
+        {
+            place_event(wheel, moving[i]);
+        }
+    }
+
+    vector<timer_event> &due = wheel.slots[0][wheel.now & (WHEEL_SLOTS - 1)];
+    size_t kept = 0;
+
+    for (size_t i = 0; i < due.size(); i++)
+    {
+        if (due[i].due <= wheel.now)
+        {
+            fired.push_back(due[i]);
+            wheel.pending--;
+            live_resources.timers--;
+        }
+        else
+        {
+            // only events from the top level can still be too far away
+            due[kept++] = due[i];
+        }
+    }
+    due.resize(kept);
+}
+
+void free_timer_wheel(timer_wheel &wheel)
+{
+    for (int level = 0; level < WHEEL_LEVELS; level++)
+    {
+        for (int slot = 0; slot < WHEEL_SLOTS; slot++)
+        {
+            wheel.slots[level][slot].clear();
+        }
+    }
+
+    live_resources.timers -= wheel.pending;
+    wheel.pending = 0;
+}
+
+/**
+ * Checks the wheel against a plain queue of events sorted by due tick, with
+ * delays reaching every level and past the top one, and events scheduled
+ * while the wheel is turning. Every event has to fire on exactly its tick.
+ * 
+ * @return  false if an event fired on the wrong tick, after writing which
+ */
+bool check_timer_wheel()
+{
+    const int events = 3000;
+    game_rng rng = new_rng(1);
+    timer_wheel wheel = new_timer_wheel();
+
+    // the expected events as (due, payload), soonest first
+    priority_queue<pair<unsigned long long, unsigned int>, vector<pair<unsigned long long, unsigned int>>, greater<pair<unsigned long long, unsigned int>>> expected;
+    unsigned int next_payload = 0;
+
+    auto schedule = [&]() {
+        // up to twice as far as a level reaches, the last is past the top level
+        int level = rng_int(rng, 0, WHEEL_LEVELS + 1);
+        unsigned long long delay = rng_int(rng, 0, 2 << (WHEEL_BITS * level));
+        schedule_event(wheel, delay, DESPAWN_EVENT, next_payload);
+        expected.push({wheel.now + max(1ULL, delay), next_payload++});
+    };
+
+    for (int i = 0; i < events; i++)
+    {
+        schedule();
+    }
+
+    vector<timer_event> fired;
+    vector<unsigned int> fired_payloads, due_payloads;
+
+    while (not expected.empty())
+    {
+        fired.clear();
+        advance_timer_wheel(wheel, fired);
+
+        fired_payloads.clear();
+        due_payloads.clear();
+        for (size_t i = 0; i < fired.size(); i++)
+        {
+            fired_payloads.push_back(fired[i].payload);
+        }
+        while (not expected.empty() and expected.top().first == wheel.now)
+        {
+            due_payloads.push_back(expected.top().second);
+            expected.pop();
+        }
+        sort(fired_payloads.begin(), fired_payloads.end());
+
+        if (fired_payloads != due_payloads)
+        {
+            write_line("timer wheel fired " + to_string(fired_payloads.size()) + " events on tick " + to_string(wheel.now) + " instead of " + to_string(due_payloads.size()));
+            free_timer_wheel(wheel);
+            return false;
+        }
+
+        // the game schedules from inside the events it handles
+        for (size_t i = 0; i < fired.size() and next_payload < 2 * events; i++)
+        {
+            schedule();
+        }
+    }
+
+    bool empty = wheel.pending == 0;
+    free_timer_wheel(wheel);
+
+    if (not empty)
+        write_line("timer wheel still has events after the last one was due");
+    return empty;
+}
+
+//                                      ●▬▬▬▬   »»»       zoom.𝗵       «««  ▬▬▬▬▬●
+
+#define IMPOSTOR_ZOOM 0.125f
+#define IMPOSTOR_CELL 2
+#define IMPOSTOR_BENCH_FRAMES 120
+
+/**
+ * A run of impostor cells of the same shade next to each other in a row,
+ * drawn as one rectangle.
+ * 
+ * @field   column, row     the first cell of the run
+ * @field   length          cells in the run
+ * @field   shade           the colour of the run in the batch's palette
+ */
+struct impostor_run
+{
+    uint16_t column, row;
+    uint16_t length;
+    uint8_t shade;
+};
+
+/**
+ * When the camera is zoomed out past IMPOSTOR_ZOOM the entities are too
+ * small to see as bitmaps, so each one colours a cell of a grid over the
+ * screen instead, like the minimap. Cells of the same colour next to each
+ * other in a row are drawn as one rectangle, so a crowded screen needs far
+ * fewer draws than it has entities.
+ * 
+ * @field   columns, rows   size of the grid in cells
+ * @field   cells           the shade of each cell, 0 for an empty cell
+ * @field   palette         the colour of each shade, shade n is palette[n - 1]
+ * @field   runs            the rectangles to draw, worked out from the cells
+ */
+struct impostor_batch
+{
+    int columns, rows;
+    vector<uint8_t> cells;
+    vector<color> palette;
+    vector<impostor_run> runs;
+};
+
+/**
+ * Makes an empty batch covering the screen.
+ * 
+ * @param width, height     size of the screen, 0 for a batch that is never drawn
+ */
+impostor_batch new_impostor_batch(int width, int height);
+
+/**
+ * Empties every cell, ready for the next frame.
+ */
+void clear_impostors(impostor_batch &batch);
+
+/**
+ * Colours the cell under a point of the world, if it is on the screen.
+ * 
+ * @param batch     the batch to add to
+ * @param view      the part of the world on the screen
+ * @param zoom      how big the world is drawn
+ * @param x, y      the point in the world
+ * @param tint      the colour of the point, later points cover earlier ones
+ */
+void add_impostor(impostor_batch &batch, const rectangle &view, float zoom, float x, float y, const color &tint);
+
+/**
+ * Joins the coloured cells into runs.
+ */
+void build_impostor_runs(impostor_batch &batch);
+
+/**
+ * Draws the runs of the batch on the screen.
+ * 
+ * @param batch     the batch with its runs built
+ * @param frame     the frame being recorded
+ */
+void draw_impostors(const impostor_batch &batch, render_list &frame);
+
+/**
+ * Fills a batch with count entities spread over the active chunks, seen
+ * from the furthest zoom, and times the batching against the 60 Hz frame budget.
+ * 
+ * @param count     entities on the screen
+ */
+void run_impostor_benchmark(int count);
+
+//                                      ●▬▬▬▬   »»»       zoom.cpp       «««  ▬▬▬▬▬●
+
+impostor_batch new_impostor_batch(int width, int height)
+{
+    impostor_batch result;
+    result.columns = width / IMPOSTOR_CELL;
+    result.rows = height / IMPOSTOR_CELL;
+    result.cells.assign((size_t)result.columns * result.rows, 0);
+    return result;
+}
+
+void clear_impostors(impostor_batch &batch)
+{
+    fill(batch.cells.begin(), batch.cells.end(), 0);
+}
+
+/**
+ * the shade of a colour in the batch's palette, added the first time it is seen.
+ * there are only a handful of colours, so looking through them is quick
+ */
+uint8_t impostor_shade(impostor_batch &batch, const color &tint)
+{
+    for (size_t i = 0; i < batch.palette.size(); i++)
+    {
+        const color &known = batch.palette[i];
+        if (known.r == tint.r and known.g == tint.g and known.b == tint.b and known.a == tint.a)
+            return i + 1;
+    }
+
+    // past 255 colours the last one is reused
+    if (batch.palette.size() < 255)
+        batch.palette.push_back(tint);
+    return batch.palette.size();
+}
+
+void add_impostor(impostor_batch &batch, const rectangle &view, float zoom, float x, float y, const color &tint)
+{
+    float column = (x - view.x) * zoom / IMPOSTOR_CELL, row = (y - view.y) * zoom / IMPOSTOR_CELL;
+    if (column < 0 or row < 0 or column >= batch.columns or row >= batch.rows)
+        return;
+
+    batch.cells[(size_t)row * batch.columns + (size_t)column] = impostor_shade(batch, tint);
+}
+
+void build_impostor_runs(impostor_batch &batch)
+{
+    batch.runs.clear();
+
+    for (int row = 0; row < batch.rows; row++)
+    {
+        const uint8_t *cells = batch.cells.data() + (size_t)row * batch.columns;
+
+        for (int column = 0; column < batch.columns;)
+        {
+            uint8_t shade = cells[column];
+            int length = 1;
+            while (column + length < batch.columns and cells[column + length] == shade)
+                length++;
+
+            if (shade != 0)
+                batch.runs.push_back({(uint16_t)column, (uint16_t)row, (uint16_t)length, shade});
+            column += length;
+        }
+    }
+}
+
+void draw_impostors(const impostor_batch &batch, render_list &frame)
+{
+    for (size_t i = 0; i < batch.runs.size(); i++)
+    {
+        const impostor_run &run = batch.runs[i];
+        record_fill_rectangle(frame, LAYER_SHIPS, batch.palette[run.shade - 1], run.column * IMPOSTOR_CELL, run.row * IMPOSTOR_CELL, run.length * IMPOSTOR_CELL, IMPOSTOR_CELL);
+    }
+}
+
+void run_impostor_benchmark(int count)
+{
+    impostor_batch batch = new_impostor_batch(WINDOW_WIDTH, WINDOW_HEIGHT);
+    rectangle view;
+    view.x = view.y = 0;
+    view.width = WINDOW_WIDTH / ZOOM_MIN;
+    view.height = WINDOW_HEIGHT / ZOOM_MIN;
+    game_rng rng = new_rng(count);
+    const color tints[3] = {MINIMAP_FOE, MINIMAP_POWER_UP, MINIMAP_ALLY};
+
+    // the same entities every frame, as a paused strategic view would have.
+    // only the active chunks have entities, and the player is in their middle
+    float side = GRAVITY_ACTIVE_SIDE * CHUNK_SIZE;
+    vector<float> x(count), y(count);
+    vector<int> tint(count);
+    for (int i = 0; i < count; i++)
+    {
+        x[i] = (view.width - side) / 2 + rng_float(rng) * side;
+        y[i] = (view.height - side) / 2 + rng_float(rng) * side;
+        tint[i] = rng_int(rng, 0, 3);
+    }
+
+    double total_ms = 0, worst_ms = 0;
+    for (int frame = 0; frame < IMPOSTOR_BENCH_FRAMES; frame++)
+    {
+        auto start = chrono::steady_clock::now();
+
+        clear_impostors(batch);
+        for (int i = 0; i < count; i++)
+        {
+            add_impostor(batch, view, ZOOM_MIN, x[i], y[i], tints[tint[i]]);
+        }
+        build_impostor_runs(batch);
+
+        double frame_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        total_ms += frame_ms;
+        worst_ms = max(worst_ms, frame_ms);
+    }
+
+    double budget_ms = 1000.0 / 60;
+    write_line(to_string(count) + " entities at zoom " + to_string(ZOOM_MIN) + " drawn as " + to_string(batch.runs.size()) + " rectangles");
+    write_line("batching: " + to_string(total_ms / IMPOSTOR_BENCH_FRAMES) + " ms per frame, worst " + to_string(worst_ms) + " ms, " + to_string(100 * total_ms / IMPOSTOR_BENCH_FRAMES / budget_ms) + "% of the 60 Hz budget");
+}
+
+//                                      ●▬▬▬▬   »»»       screen.𝗵       «««  ▬▬▬▬▬●
+
+#define IDLE_POLL_MS 50
+#define IDLE_REFRESH_MS 1000
+
+/**
+ * The parts of the window that have to be drawn again before it is next
+ * shown. A new tracker has the whole window to draw, as the window still
+ * holds whatever was on it before.
+ * 
+ * @field   areas       the rectangles to draw, none of them overlapping
+ * @field   last_shown  when the window was last shown
+ */
+struct dirty_tracker
+{
+    vector<rectangle> areas;
+    chrono::steady_clock::time_point last_shown;
+};
+
+/**
+ * A screen that only changes when the player presses a key: a bitmap over
+ * the whole window with maybe a line of text on it.
+ * 
+ * @field   background  name of the bitmap, empty before anything is shown
+ * @field   text        the line of text, empty for none
+ * @field   font        name of the text's font
+ * @field   size        size of the font
+ * @field   tint        colour of the text
+ * @field   x, y        top left of the text
+ */
+struct still_screen
+{
+    string background;
+    string text;
+    string font;
+    int size;
+    color tint;
+    double x, y;
+};
+
+/**
+ * Creates a tracker with the whole window to draw.
+ */
+dirty_tracker new_dirty_tracker();
+
+/**
+ * Adds an area to draw again. Areas it overlaps are merged into one with it,
+ * so no part of the window is drawn twice.
+ * 
+ * @param tracker   the tracker
+ * @param area      the part of the window that changed
+ */
+void mark_dirty(dirty_tracker &tracker, const rectangle &area);
+
+/**
+ * Creates a still screen showing a bitmap with no text.
+ * 
+ * @param background    name of the bitmap
+ */
+still_screen new_still_screen(const string &background);
+
+/**
+ * Shows the next state of a still screen. Only the parts that differ from what
+ * is shown are drawn, and when nothing differs the window is left alone and
+ * the program sleeps for IDLE_POLL_MS instead of drawing a frame.
+ * 
+ * @param tracker   the parts of the window still to draw
+ * @param shown     what is on the window, changed to next
+ * @param next      what the window should show
+ */
+void show_still_screen(dirty_tracker &tracker, still_screen &shown, const still_screen &next);
+
+//                                      ●▬▬▬▬   »»»       screen.cpp       «««  ▬▬▬▬▬●
+
+dirty_tracker new_dirty_tracker()
+{
+    dirty_tracker result;
+    mark_dirty(result, rectangle_from(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT));
+    result.last_shown = chrono::steady_clock::now();
+    return result;
+}
+
+/**
+ * true when two rectangles share some of their area, unlike
+ * rectangles_intersect which counts touching edges
+ */
+bool areas_overlap(const rectangle &a, const rectangle &b)
+{
+    return a.x < b.x + b.width and b.x < a.x + a.width and a.y < b.y + b.height and b.y < a.y + a.height;
+}
+
+void mark_dirty(dirty_tracker &tracker, const rectangle &area)
+{
+    rectangle merged = area;
+
+    // a merged area is bigger, so it can reach areas the first one did not
+    for (size_t i = 0; i < tracker.areas.size();)
+    {
+        const rectangle &other = tracker.areas[i];
+        if (not areas_overlap(merged, other))
+        {
+            i++;
+            continue;
+        }
+
+        double left = min(merged.x, other.x), top = min(merged.y, other.y);
+        double right = max(merged.x + merged.width, other.x + other.width), bottom = max(merged.y + merged.height, other.y + other.height);
+        merged = rectangle_from(left, top, right - left, bottom - top);
+
+        tracker.areas.erase(tracker.areas.begin() + i);
+        i = 0;
+    }
+
+    tracker.areas.push_back(merged);
+}
+
+still_screen new_still_screen(const string &background)
+{
+    still_screen result;
+    result.background = background;
+    result.text = "";
+    result.font = "";
+    result.size = 0;
+    result.tint = COLOR_WHITE;
+    result.x = result.y = 0;
+    return result;
+}
+
+/**
+ * the part of the window covered by the screen's text, nothing without text
+ */
+rectangle still_text_area(const still_screen &screen)
+{
+    if (screen.text.empty())
+        return rectangle_from(screen.x, screen.y, 0, 0);
+    return rectangle_from(screen.x, screen.y, text_width(screen.text, screen.font, screen.size), text_height(screen.text, screen.font, screen.size));
+}
+
+void show_still_screen(dirty_tracker &tracker, still_screen &shown, const still_screen &next)
+{
+    if (next.background != shown.background)
+    {
+        // whatever the bitmap does not cover stays black
+        clear_screen(COLOR_BLACK);
+        mark_dirty(tracker, rectangle_from(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT));
+    }
+    else if (next.text != shown.text or next.font != shown.font or next.size != shown.size or next.x != shown.x or next.y != shown.y)
+    {
+        mark_dirty(tracker, still_text_area(shown));
+        mark_dirty(tracker, still_text_area(next));
+    }
+    shown = next;
+
+    // the text is drawn whole, so an area that reaches it takes all of it
+    rectangle text = still_text_area(shown);
+    for (size_t i = 0; i < tracker.areas.size(); i++)
+    {
+        if (areas_overlap(tracker.areas[i], text))
+        {
+            mark_dirty(tracker, text);
+            break;
+        }
+    }
+
+    auto now = chrono::steady_clock::now();
+    if (tracker.areas.empty())
+    {
+        // shown now and then anyway, so a window uncovered by another gets its picture back
+        if (now - tracker.last_shown >= chrono::milliseconds(IDLE_REFRESH_MS))
+        {
+            refresh_screen();
+            tracker.last_shown = now;
+        }
+        this_thread::sleep_for(chrono::milliseconds(IDLE_POLL_MS));
+        return;
+    }
+
+    for (size_t i = 0; i < tracker.areas.size(); i++)
+    {
+        const rectangle &area = tracker.areas[i];
+        draw_bitmap(shown.background, area.x, area.y, option_part_bmp(area.x, area.y, area.width, area.height, option_to_screen()));
+
+        if (areas_overlap(area, text))
+            draw_text(shown.text, shown.tint, shown.font, shown.size, shown.x, shown.y, option_to_screen());
+    }
+
+    tracker.areas.clear();
+    refresh_screen();
+    tracker.last_shown = now;
+}
+
+//                                      ●▬▬▬▬   »»»       pacer.𝗵       «««  ▬▬▬▬▬●
+
+#define PACER_SPIN_MS 2.0
+#define PACER_RESYNC_FRAMES 4
+#define PACER_STATS_FRAMES 300
+#define TIMING_BUCKETS 12
+
+// upper bounds of the timing buckets in ms, past the last one counts as too slow
+constexpr double TIMING_BOUNDS_MS[TIMING_BUCKETS] = {0.1, 0.25, 0.5, 1, 2, 4, 8, 16.7, 33.3, 50, 100, 250};
+
+/**
+ * Counts how many timings fell in each bucket.
+ * 
+ * @field   counts      timings up to each bound in TIMING_BOUNDS_MS, and the ones over the last
+ * @field   total       number of timings
+ * @field   sum_ms      all the timings added up
+ * @field   worst_ms    the longest timing
+ */
+struct timing_histogram
+{
+    uint64_t counts[TIMING_BUCKETS + 1];
+    uint64_t total;
+    double sum_ms;
+    double worst_ms;
+};
+
+/**
+ * Keeps the frames of the window on a steady beat. The pacer waits until
+ * just before a frame is due, so the input read after it is as fresh as it
+ * can be by the time the frame is on the screen.
+ * 
+ * @field   period          time between frames
+ * @field   next_present    when the next frame should be on the screen
+ * @field   last_present    when the last frame went on the screen
+ * @field   input_read      when the input of the current frame was read
+ * @field   work_ms         how long reading the input up to showing the frame takes, erring long
+ * @field   frames          frames shown
+ * @field   jitter          how far each frame was from its beat
+ * @field   latency         time from reading the input to showing the frame it changed
+ * @field   stats_path      file the histograms are written to, empty for none
+ */
+struct frame_pacer
+{
+    chrono::steady_clock::duration period;
+    chrono::steady_clock::time_point next_present;
+    chrono::steady_clock::time_point last_present;
+    chrono::steady_clock::time_point input_read;
+    double work_ms;
+    uint64_t frames;
+    timing_histogram jitter;
+    timing_histogram latency;
+    string stats_path;
+};
+
+/**
+ * Creates a histogram with no timings.
+ */
+timing_histogram new_timing_histogram();
+
+/**
+ * Adds a timing to its bucket.
+ * 
+ * @param histogram     the histogram
+ * @param ms            the timing in ms
+ */
+void add_timing(timing_histogram &histogram, double ms);
+
+/**
+ * Creates a pacer for a number of frames a second, due to show its first frame now.
+ * 
+ * @param frame_rate    frames a second
+ * @param stats_path    file the histograms are written to every PACER_STATS_FRAMES frames, empty for none
+ */
+frame_pacer new_frame_pacer(int frame_rate, const string &stats_path);
+
+/**
+ * Waits until the input of the next frame should be read: the frame's beat
+ * less the time the frame takes. Sleeps most of the wait, then spins for the
+ * last PACER_SPIN_MS as sleeps can wake late.
+ * 
+ * @param pacer     the pacer
+ */
+void wait_for_frame(frame_pacer &pacer);
+
+/**
+ * Tells the pacer the frame is on the screen, to time it and plan the next.
+ * 
+ * @param pacer     the pacer
+ */
+void frame_presented(frame_pacer &pacer);
+
+/**
+ * Writes the histograms to the pacer's stats file in the prometheus text
+ * format, for node exporter's textfile collector or any scraper reading it.
+ * The file is replaced whole, so a reader never sees half of it.
+ * 
+ * @param pacer     the pacer
+ */
+void write_frame_stats(const frame_pacer &pacer);
+
+//                                      ●▬▬▬▬   »»»       pacer.cpp       «««  ▬▬▬▬▬●
+
+timing_histogram new_timing_histogram()
+{
+    timing_histogram result;
+    fill(begin(result.counts), end(result.counts), 0);
+    result.total = 0;
+    result.sum_ms = 0;
+    result.worst_ms = 0;
+    return result;
+}
+
+void add_timing(timing_histogram &histogram, double ms)
+{
+    int bucket = 0;
+    while (bucket < TIMING_BUCKETS and ms > TIMING_BOUNDS_MS[bucket])
+        bucket++;
+
+    histogram.counts[bucket]++;
+    histogram.total++;
+    histogram.sum_ms += ms;
+    histogram.worst_ms = max(histogram.worst_ms, ms);
+}
+
+frame_pacer new_frame_pacer(int frame_rate, const string &stats_path)
+{
+    frame_pacer result;
+    result.period = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(1.0 / frame_rate));
+    result.next_present = result.last_present = result.input_read = chrono::steady_clock::now();
+    result.work_ms = 0;
+    result.frames = 0;
+    result.jitter = new_timing_histogram();
+    result.latency = new_timing_histogram();
+    result.stats_path = stats_path;
+    return result;
+}
+
+/**
+ * sleeps until a bit before the deadline, then spins the rest of the way
+ */
+void wait_until(chrono::steady_clock::time_point deadline)
+{
+    auto spin = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double, milli>(PACER_SPIN_MS));
+
+    if (deadline - chrono::steady_clock::now() > spin)
+        this_thread::sleep_until(deadline - spin);
+
+    while (chrono::steady_clock::now() < deadline)
+        this_thread::yield();
+}
+
+void wait_for_frame(frame_pacer &pacer)
+{
+    auto work = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double, milli>(pacer.work_ms));
+    wait_until(pacer.next_present - work);
+    pacer.input_read = chrono::steady_clock::now();
+}
+
+void frame_presented(frame_pacer &pacer)
+{
+    auto now = chrono::steady_clock::now();
+    double period_ms = chrono::duration<double, milli>(pacer.period).count();
+    double work_ms = chrono::duration<double, milli>(now - pacer.input_read).count();
+    double since_last_ms = chrono::duration<double, milli>(now - pacer.last_present).count();
+
+    // a gap of a few frames is a menu or a new game, not a frame shown late
+    if (pacer.frames > 0 and since_last_ms < PACER_RESYNC_FRAMES * period_ms)
+        add_timing(pacer.jitter, abs(since_last_ms - period_ms));
+    add_timing(pacer.latency, work_ms);
+
+    // a slow frame pushes the estimate up at once, fast ones only bring it down slowly
+    pacer.work_ms = min(period_ms, max(work_ms, pacer.work_ms * 0.95 + work_ms * 0.05));
+
+    // once a whole frame behind, the beat starts again from now instead of rushing to catch up
+    pacer.next_present += pacer.period;
+    if (pacer.next_present < now)
+        pacer.next_present = now + pacer.period;
+
+    pacer.last_present = now;
+    pacer.frames++;
+
+    if (not pacer.stats_path.empty() and pacer.frames % PACER_STATS_FRAMES == 0)
+        write_frame_stats(pacer);
+}
+
+/**
+ * writes one histogram in the prometheus text format, its buckets counting
+ * every timing up to their bound like prometheus expects
+ */
+void write_timing_histogram(ofstream &file, const string &name, const string &help, const timing_histogram &histogram)
+{
+    file << "# HELP " << name << " " << help << "\n";
+    file << "# TYPE " << name << " histogram\n";
+
+    uint64_t below = 0;
+    for (int i = 0; i < TIMING_BUCKETS; i++)
+    {
+        below += histogram.counts[i];
+        file << name << "_bucket{le=\"" << TIMING_BOUNDS_MS[i] << "\"} " << below << "\n";
+    }
+    file << name << "_bucket{le=\"+Inf\"} " << histogram.total << "\n";
+    file << name << "_sum " << histogram.sum_ms << "\n";
+    file << name << "_count " << histogram.total << "\n";
+}
+
+void write_frame_stats(const frame_pacer &pacer)
+{
+    string partial = pacer.stats_path + ".part";
+    {
+        ofstream file(partial);
+        write_timing_histogram(file, "space_wars_frame_jitter_ms", "How far each frame was shown from its beat, in ms.", pacer.jitter);
+        write_timing_histogram(file, "space_wars_input_latency_ms", "Time from reading the input to showing the frame it changed, in ms. The display adds its own delay on top.", pacer.latency);
+        file << "# HELP space_wars_frames_total Frames shown.\n";
+        file << "# TYPE space_wars_frames_total counter\n";
+        file << "space_wars_frames_total " << pacer.frames << "\n";
+    }
+
+    error_code error;
+    filesystem::rename(partial, pacer.stats_path, error);
+    if (error)
+        write_line("could not write the frame stats to " + pacer.stats_path);
+}
+
+//                                      ●▬▬▬▬   »»»       space_wars.𝗵       «««  ▬▬▬▬▬●
+
+#define PICKUP_MAGNET_RADIUS 180
+#define PICKUP_MAGNET_PULL 2.5
+#define LOD_SLEEP_TICKS 120
+#define LOD_MIN_ENTITIES 256
+#define FOE_DESTROYED_SCORE 20
+
+/**
+ * The game_data keeps track of all of the information related to the game.
+ * 
+ * @field   player          player created for the game
+ * @field   spawn           the registry which will contain the active entities
+ * @field   world           the chunks of the world, saving entities away from the player
+ * @field   systems         the systems run over the entities every update
+ * @field   pickups         types of the entities picked up during this update
+ * @field   static_pickups  types of the static entities picked up during this update, kept
+ *                          apart so the two pickup systems can run at the same time
+ * @field   hits            types of the hostile entities that hit the player during this update
+ * @field   headless        true when the game runs without a window, sounds or sprites
+ * @field   ticks           number of updates since the game started
+ * @field   timers          the events waiting to happen (spawns, shield expiry, despawns)
+ * @field   expired         ids of the entities whose lifetime ran out during this update
+ * @field   game_over_by    checks if player lost by getting hit or due to low fuel 
+ * @field   rng             the game's own random numbers, so games can run side by side
+ * @field   spatial         grid of the moving entities, rebuilt at the end of every update
+ * @field   static_spatial  grid of the static entities, only rebuilt when they are added or removed
+ * @field   static_built    the spawner's static_changes when static_spatial was built
+ * @field   nearby          reused list for the results of spatial queries
+ * @field   nearby_static   a second reused list, for when the results of both grids are needed at once
+ * @field   projectiles     what the player shot that is still flying
+ * @field   fire_ready      the tick the player can shoot each kind of projectile again
+ * @field   particles       explosions and sparkles, empty when headless
+ * @field   gravity         the planets and their pull on the player and the moving entities
+ * @field   hunt            flow field over the active chunks leading the foes to the player
+ * @field   swarm           the foes flock together instead of hunting on their own
+ * @field   flock           the reused lists of the flocking foes
+ * @field   impostors       the entities as coloured cells when zoomed far out, empty when headless
+ * @field   frame           the draws of the frame being recorded
+ * @field   worker_frames   the draws recorded by each worker thread, added to the frame after
+ * @field   pool            threads the updates and draws are split over, not owned by the game,
+ *                          nullptr to do everything on the game's own thread
+ */
+struct game_data
+{
+    player_data player;
+    entity_registry spawner;
+    world_data world;
+    scheduler_data systems;
+    vector<entity_type> pickups;
+    vector<entity_type> static_pickups;
+    vector<entity_type> hits;
+    bool headless;
+    unsigned long long ticks;
+    timer_wheel timers;
+    unordered_set<unsigned int> expired;
+    int game_over_by;
+    game_rng rng;
+    spatial_index spatial;
+    spatial_index static_spatial;
+    unsigned long long static_built;
+    vector<spatial_hit> nearby;
+    vector<spatial_hit> nearby_static;
+    projectile_pool projectiles;
+    unsigned long long fire_ready[PROJECTILE_KIND_COUNT];
+    particle_system particles;
+    gravity_field gravity;
+    flow_field hunt;
+    bool swarm;
+    flock_data flock;
+    impostor_batch impostors;
+    render_list frame;
+    vector<render_list> worker_frames;
+    worker_pool *pool;
+};
+
+/**
+ * Creates a new game with a new player on the screen. The game only uses
+ * its own data, so any number of headless games can be played at once on
+ * different threads.
+ * 
+ * @param headless  true to run the game without a window, sounds or sprites
+ * @param seed      seed for the game's random numbers
+ */
+game_data new_game(bool headless, uint64_t seed);
+
+/**
+ * Turns a new game into the swarm mode: SWARM_FOES foes are spread around
+ * the player's chunks and flock together towards the player from then on.
+ * 
+ * @param game  the game to change, just after new_game
+ */
+void start_swarm(game_data &game);
+
+/**
+ * Frees everything the game holds: the entities, the saved chunks
+ * and the waiting timer events.
+ * 
+ * @param game  The game to free
+ */
+void free_game(game_data &game);
+
+/**
+ * Draws the game on the screen. The draws are recorded into the game's
+ * frame, which is drawn in one go once the hud is added to it.
+ * 
+ * @param game_draw    The game to draw to the screen
+ */
+void draw_game(game_data &game_draw);
+
+/**
+ * updates the game checking for changes in player
+ * also checks the updates and spawning of power ups 
+ * 
+ * @param game_update      The game being updated
+ */
+void update_game(game_data &game_update);
+
+/**
+ * Shoots a projectile from the player towards a point, if the player
+ * has waited long enough since the last one of that kind.
+ * 
+ * @param game      the main game variable used in various tasks
+ * @param kind      the kind of projectile
+ * @param target    the point to shoot at
+ */
+void fire_player_projectile(game_data &game, projectile_kind kind, const point_2d &target);
+
+/**
+ * Shoots bullets at the mouse while space is held, and bombs while B is held.
+ * 
+ * @param game  the main game variable used in various tasks
+ */
+void handle_fire_input(game_data &game);
+
+//                                      ●▬▬▬▬   »»»       space_wars.cpp       «««  ▬▬▬▬▬●
+
+/**
+ * plays a sound effect, unless the game runs without a window
+ * 
+ * @param game  the main game variable used in various tasks
+ * @param name  name of the sound effect
+ */
+void play_game_sound(const game_data &game, const string &name)
+{
+    if (not game.headless)
+        play_sound_effect(name);
+}
+
+/**
+ * plays the sound of an entity when the player touches it,
+ * picking one at random if the entity has more than one
+ * 
+ * @param game  the main game variable used in various tasks
+ * @param type  the type of entity the player touched
+ */
+void play_entity_sound(const game_data &game, entity_type type)
+{
+    // picking the sound uses rnd(), which is shared by every game
+    if (game.headless)
+        return;
+
+    const entity_archetype &archetype = ENTITY_ARCHETYPES[type];
+    play_game_sound(game, archetype.sounds[rnd(archetype.sound_count)]);
+}
+
+/**
+ * this function is used to apply a specific power up
+ * or see if player picked up ally
+ * or if player decided to attack the foe without thinking
+ * 
+ * @param game  the main game variable used in various tasks
+ * @param type  the type of entity the player touched
+ */
+void apply_spawn(game_data &game, entity_type type)
+{
+    const entity_archetype &archetype = ENTITY_ARCHETYPES[type];
+    point_2d center = player_center(game.player);
+
+    if (archetype.components & HOSTILE)
+    {
+        emit_particles(game.particles, EXPLOSION, center.x, center.y);
+
+        if (game.player.shield == false)
+        {
+            game.player.game_over = true;
+            game.game_over_by = 1;
+
+            play_entity_sound(game, type);
+        }
+        else
+        {
+            play_game_sound(game, "shield_hit");
+        }
+        game.player.shield = false;
+        return;
+    }
+
+    play_entity_sound(game, type);
+    emit_particles(game.particles, archetype.components & STATIC ? ALLY_SPARKLE : POWER_UP_SPARKLE, center.x, center.y);
+    game.player.score += archetype.score;
+
+    // Increasing the fuel only till the tank is full
+    game.player.fuel_pct = min(1.0, game.player.fuel_pct + archetype.fuel);
+
+    if (archetype.shield)
+    {
+        game.player.shield = true;
+
+        // a new shield replaces the old one, so only the newest expiry counts
+        game.player.shield_count++;
+        schedule_event(game.timers, seconds_to_ticks(SHIELD_SECONDS), SHIELD_EXPIRY_EVENT, game.player.shield_count);
+    }
+}
+
+/**
+ * this function is used to check collision of an entity with player
+ * 
+ * @param game      the main game variable used in various tasks
+ * @param entities  the entities being checked
+ * @param num       index of the entity
+ * @return          true if the entity touches the player
+ */
+bool touches_player(const game_data &game, const entity_store &entities, size_t num)
+{
+    const player_data &player = game.player;
+
+    // turned ships reach out of their boxes, the masks are checked against the squares they are turned in
+    if (player.ship)
+        return rotated_collision(*player.ship, player.heading, player.x, player.y, entity_turns(entities.type[num]), entity_heading(entities, num), entities.x[num], entities.y[num]);
+
+    // only entities whose box overlaps the player's box need the exact test
+    if (entities.x[num] > player.x + player.width or entities.y[num] > player.y + player.height or entities.x[num] + entities.width[num] < player.x or entities.y[num] + entities.height[num] < player.y)
+        return false;
+
+    // without a window there are no bitmaps, so the ships are treated as circles
+    // a little smaller than their boxes, as the pictures do not fill them
+    point_2d centre = player_center(player);
+    double ex = entities.x[num] + entities.width[num] / 2 - centre.x;
+    double ey = entities.y[num] + entities.height[num] / 2 - centre.y;
+    double reach = HEADLESS_HIT_SCALE * (min(player.width, player.height) + min(entities.width[num], entities.height[num])) / 2;
+
+    return ex * ex + ey * ey < reach * reach;
+}
+
+/**
+ * rebuilds the grid of the moving entities, and the grid of the static
+ * ones only if static entities were added or removed since it was built
+ * 
+ * @param game  the main game variable used in various tasks
+ */
+void update_spatial_indexes(game_data &game)
+{
+    build_spatial_index(game.spatial, game.spawner, 0, STATIC);
+
+    if (game.static_built == game.spawner.static_changes and game.static_spatial.cell_start.size() > 0)
+        return;
+
+    build_spatial_index(game.static_spatial, game.spawner, STATIC, 0);
+    game.static_built = game.spawner.static_changes;
+}
+
+/**
+ * system that collects the pickups touching the player
+ * they are only marked dead here, the power up is applied after
+ * all the systems ran and they are removed at the end of the update
+ */
+void pickup_system(game_data &game, archetype_data &archetype)
+{
+    entity_store &entities = archetype.entities;
+
+    for (size_t num = 0; num < entity_count(entities); num++)
+    {
+        if (not entities.dead[num] and touches_player(game, entities, num))
+        {
+            game.pickups.push_back(entities.type[num]);
+            entities.dead[num] = true;
+        }
+    }
+}
+
+/**
+ * system that collects the static pickups (allies) touching the player.
+ * instead of testing every ally it asks the static grid for the ones
+ * close enough to touch, which is usually none
+ */
+void static_pickup_system(game_data &game, archetype_data &archetype)
+{
+    entity_store &entities = archetype.entities;
+    point_2d centre = player_center(game.player);
+
+    // an ally can only touch when its centre is within both half diagonals
+    float reach = hypot(game.player.width, game.player.height) / 2 + entity_max_extent() * 0.7072f;
+
+    // no other system uses this list, so it is safe while the rest of the stage runs
+    vector<spatial_hit> &near = game.nearby_static;
+    near.clear();
+    spatial_in_radius(game.static_spatial, centre.x, centre.y, reach, archetype.components, near);
+
+    for (size_t i = 0; i < near.size(); i++)
+    {
+        // the grid holds every static archetype, this system runs once for each
+        if (&game.spawner.archetypes[ref_archetype(near[i].ref)] != &archetype)
+            continue;
+
+        size_t num = ref_index(near[i].ref);
+        if (not entities.dead[num] and touches_player(game, entities, num))
+        {
+            game.static_pickups.push_back(entities.type[num]);
+            entities.dead[num] = true;
+        }
+    }
+}
+
+/**
+ * system that finds the hostile entities hitting the player
+ */
+void hostile_system(game_data &game, archetype_data &archetype)
+{
+    entity_store &entities = archetype.entities;
+
+    for (size_t num = 0; num < entity_count(entities); num++)
+    {
+        if (not entities.dead[num] and touches_player(game, entities, num))
+        {
+            game.hits.push_back(entities.type[num]);
+            entities.dead[num] = true;
+        }
+    }
+}
+
+/**
+ * system that marks the entities that left the chunks around the player
+ */
+void range_system(game_data &game, archetype_data &archetype)
+{
+    mark_far_entities(archetype, player_center(game.player));
+}
+
+/**
+ * system that marks the static entities the player left behind. they
+ * never move and only spawn in range, so while the player stays in the
+ * same chunk none of them can be far
+ */
+void static_range_system(game_data &game, archetype_data &archetype)
+{
+    point_2d centre = player_center(game.player);
+
+    if (chunk_at(centre.x, centre.y) == game.world.centre_chunk)
+        archetype.far.assign(entity_count(archetype.entities), 0);
+    else
+        mark_far_entities(archetype, centre);
+}
+
+/**
+ * picks how often an entity should move from how long it would
+ * take at least to come into view or reach the player
+ * 
+ * @param ticks_away    updates before the entity could be seen
+ * @return              updates between the entity's moves, 0 to sleep
+ */
+float lod_interval(float ticks_away)
+{
+    // a longer interval is only used when the entity stays out of view until
+    // the intervals are picked again and it has made one more move after that.
+    // the distances are all mixed up, so this picks without branching
+    float interval = 1;
+    interval = ticks_away >= ENTITY_MAX_INTERVAL + 4 * 1 ? 2 : interval;
+    interval = ticks_away >= ENTITY_MAX_INTERVAL + 4 * 2 ? 4 : interval;
+    interval = ticks_away >= ENTITY_MAX_INTERVAL + 4 * 4 ? 8 : interval;
+    return ticks_away >= LOD_SLEEP_TICKS ? 0 : interval;
+}
+
+/**
+ * system that slows down the entities far from the player and puts to
+ * sleep the ones that can not matter for a while. the intervals are picked
+ * again every ENTITY_MAX_INTERVAL updates, which is also how the sleeping
+ * entities wake up once the player comes closer
+ */
+void lod_system(game_data &game, archetype_data &archetype)
+{
+    if (game.ticks % ENTITY_MAX_INTERVAL != 0)
+        return;
+
+    entity_store &entities = archetype.entities;
+    point_2d centre = player_center(game.player);
+
+    // a few entities move faster than their intervals can be worked out
+    if (entity_count(entities) < LOD_MIN_ENTITIES)
+    {
+        entities.interval.assign(entity_count(entities), 1);
+        return;
+    }
+
+    // the camera keeps the player in the middle, so anything closer than this may be on the screen
+    const float view = sqrt(WINDOW_WIDTH * WINDOW_WIDTH + WINDOW_HEIGHT * WINDOW_HEIGHT) / 2.0f / game.player.zoom + entity_max_extent();
+
+    for (size_t num = 0; num < entity_count(entities); num++)
+    {
+        float ex = entities.x[num] + entities.width[num] / 2 - centre.x;
+        float ey = entities.y[num] + entities.height[num] / 2 - centre.y;
+        float gap = max(0.0f, sqrt(ex * ex + ey * ey) - view);
+
+        // the player and the entity can both head straight at each other
+        float speed = sqrt(entities.dx[num] * entities.dx[num] + entities.dy[num] * entities.dy[num]);
+        entities.interval[num] = lod_interval(gap / (speed + MAX_VEL));
+    }
+}
+
+/**
+ * system that has the foes hunt the player along the flow field,
+ * keeping apart from each other with the grid of the last update
+ */
+void hunt_system(game_data &game, archetype_data &archetype)
+{
+    // the archetype's place in the registry is how the grid knows it
+    size_t a = &archetype - game.spawner.archetypes.data();
+    steer_foes(archetype.entities, a, game.hunt, game.spatial, player_center(game.player));
+}
+
+/**
+ * system that has the foes flock together towards the player in the swarm mode
+ */
+void flock_system(game_data &game, archetype_data &archetype)
+{
+    flock_entities(game.flock, archetype.entities, player_center(game.player), FLOCK_SEEK, game.pool);
+}
+
+/**
+ * system that lets the planets pull on the moving entities. sleeping
+ * entities are left alone, they would only fly off faster when they wake up
+ */
+void gravity_system(game_data &game, archetype_data &archetype)
+{
+    entity_store &entities = archetype.entities;
+
+    for (size_t num = 0; num < entity_count(entities); num++)
+    {
+        if (entities.interval[num] == 0)
+            continue;
+
+        float ax, ay;
+        sample_gravity(game.gravity, entities.x[num] + entities.width[num] / 2, entities.y[num] + entities.height[num] / 2, ax, ay);
+        if (ax == 0 and ay == 0)
+            continue;
+
+        float dx = entities.dx[num] + ax, dy = entities.dy[num] + ay;
+        float speed2 = dx * dx + dy * dy;
+
+        // saved chunks can not hold anything faster
+        if (speed2 > GRAVITY_MAX_SPEED * GRAVITY_MAX_SPEED)
+        {
+            float scale = GRAVITY_MAX_SPEED / sqrt(speed2);
+            dx *= scale;
+            dy *= scale;
+        }
+        entities.dx[num] = dx;
+        entities.dy[num] = dy;
+    }
+}
+
+/**
+ * system that moves the kinematic entities by their velocity
+ */
+void movement_system(game_data &game, archetype_data &archetype)
+{
+    update_entities(archetype.entities, game.ticks);
+}
+
+/**
+ * Creates the systems run every update. The scheduler works out which
+ * of them can run together from what they read and write.
+ * 
+ * @param swarm     true for the swarm mode, where the foes flock instead of hunting
+ */
+scheduler_data new_game_systems(bool swarm)
+{
+    scheduler_data result;
+
+    add_system(result, {"pickup", PICKUP, HOSTILE | STATIC, ACCESS_POSITION | ACCESS_DEAD | ACCESS_PLAYER, ACCESS_DEAD | ACCESS_PICKUPS, pickup_system});
+    add_system(result, {"static pickup", PICKUP | STATIC, HOSTILE, ACCESS_POSITION | ACCESS_DEAD | ACCESS_PLAYER, ACCESS_DEAD | ACCESS_STATIC_PICKUPS, static_pickup_system});
+    add_system(result, {"hostile", HOSTILE, 0, ACCESS_POSITION | ACCESS_DEAD | ACCESS_PLAYER, ACCESS_DEAD | ACCESS_HITS, hostile_system});
+    add_system(result, {"range", 0, STATIC, ACCESS_POSITION | ACCESS_PLAYER, ACCESS_FAR, range_system});
+    add_system(result, {"static range", STATIC, 0, ACCESS_POSITION | ACCESS_PLAYER, ACCESS_FAR, static_range_system});
+    add_system(result, {"lod", KINEMATIC, STATIC, ACCESS_POSITION | ACCESS_VELOCITY | ACCESS_PLAYER, ACCESS_INTERVAL, lod_system});
+    if (swarm)
+        add_system(result, {"flock", KINEMATIC | HOSTILE, STATIC, ACCESS_POSITION | ACCESS_VELOCITY | ACCESS_INTERVAL | ACCESS_PLAYER, ACCESS_VELOCITY, flock_system});
+    else
+        add_system(result, {"hunt", KINEMATIC | HOSTILE, STATIC, ACCESS_POSITION | ACCESS_VELOCITY | ACCESS_INTERVAL | ACCESS_DEAD | ACCESS_PLAYER, ACCESS_VELOCITY, hunt_system});
+    add_system(result, {"gravity", KINEMATIC, STATIC, ACCESS_POSITION | ACCESS_VELOCITY | ACCESS_INTERVAL, ACCESS_VELOCITY, gravity_system});
+    add_system(result, {"movement", KINEMATIC, STATIC, ACCESS_VELOCITY | ACCESS_POSITION | ACCESS_INTERVAL, ACCESS_POSITION, movement_system});
+
+    return result;
+}
+
+/**
+ * spawns a random entity in the spawning area of the player,
+ * the entity leaves again when its lifetime runs out
+ * 
+ * @param game  the main game variable used in various tasks
+ */
+void spawn_entity(game_data &game)
+{
+    point_2d location = player_center(game.player);
+
+    int x, y;
+
+    x = (int)location.x;
+    y = (int)location.y;
+
+    // spawns entities in spawning area of the player
+    entity_data entity = entity_spawn(x + rng_int(game.rng, MIN_SPAWN, MAX_SPAWN), y + rng_int(game.rng, MIN_SPAWN, MAX_SPAWN), game.rng);
+    unsigned int id = spawn_into(game.spawner, entity);
+
+    if (ENTITY_ARCHETYPES[entity.type].lifetime > 0)
+        schedule_event(game.timers, seconds_to_ticks(ENTITY_ARCHETYPES[entity.type].lifetime), DESPAWN_EVENT, id);
+}
+
+/**
+ * schedules the next spawn near the player. the spawns are a poisson
+ * process, so the time to the next one is exponentially distributed
+ * 
+ * @param game  the main game variable used in various tasks
+ */
+void schedule_next_spawn(game_data &game)
+{
+    double seconds = -log(1.0 - rng_float(game.rng)) / SPAWN_RATE;
+    schedule_event(game.timers, seconds_to_ticks(seconds), SPAWN_EVENT, 0);
+}
+
+/**
+ * lets the planets pull on the player. steering sets the velocity again,
+ * so the pull only builds up while the player drifts
+ * 
+ * @param game  the main game variable used in various tasks
+ */
+void apply_player_gravity(game_data &game)
+{
+    point_2d center = player_center(game.player);
+    float ax, ay;
+    sample_gravity(game.gravity, center.x, center.y, ax, ay);
+
+    vector_2d vel = vector_limit(vector_to(game.player.dx + ax, game.player.dy + ay), GRAVITY_MAX_SPEED);
+    game.player.dx = vel.x;
+    game.player.dy = vel.y;
+}
+
+/**
+ * burns fuel while the player is moving, the game
+ * is over when the tank is empty
+ * 
+ * @param game  the main game variable used in various tasks
+ */
+void update_fuel(game_data &game)
+{
+    if (game.player.dx != 0)
+        game.player.fuel_pct -= 0.00028;
+
+    if (game.player.fuel_pct <= 0)
+    {
+        game.game_over_by = 2;
+        game.player.game_over = true;
+    }
+}
+
+/**
+ * pulls the moving pickups (stars, fuel and shields) near the player
+ * towards it. The grid is from the end of the last update, entities have
+ * not moved since and new ones are only added after the old ones.
+ * 
+ * @param game  the main game variable used in various tasks
+ */
+void apply_pickup_magnet(game_data &game)
+{
+    point_2d centre = player_center(game.player);
+
+    game.nearby.clear();
+    spatial_in_radius(game.spatial, centre.x, centre.y, PICKUP_MAGNET_RADIUS, PICKUP | KINEMATIC, game.nearby);
+
+    for (size_t i = 0; i < game.nearby.size(); i++)
+    {
+        const spatial_hit &hit = game.nearby[i];
+        entity_store &entities = game.spawner.archetypes[ref_archetype(hit.ref)].entities;
+        size_t e = ref_index(hit.ref);
+
+        if (hit.distance < 1 or entities.dead[e])
+            continue;
+
+        float cx = entities.x[e] + entities.width[e] / 2;
+        float cy = entities.y[e] + entities.height[e] / 2;
+        entities.x[e] += (centre.x - cx) / hit.distance * PICKUP_MAGNET_PULL;
+        entities.y[e] += (centre.y - cy) / hit.distance * PICKUP_MAGNET_PULL;
+    }
+}
+
+/**
+ * handles the events that came due on this tick of the timer wheel
+ * 
+ * @param game  the main game variable used in various tasks
+ */
+void handle_timer_events(game_data &game)
+{
+    vector<timer_event> fired;
+    advance_timer_wheel(game.timers, fired);
+
+    for (size_t i = 0; i < fired.size(); i++)
+    {
+        switch (fired[i].kind)
+        {
+        case SPAWN_EVENT:
+            // limits the total active entities around the player, chunks bring in the rest
+            if (total_entities(game.spawner) < MAX_ACTIVE_SPAWN)
+                spawn_entity(game);
+            schedule_next_spawn(game);
+            break;
+
+        case SHIELD_EXPIRY_EVENT:
+            if (game.player.shield and fired[i].payload == game.player.shield_count)
+                game.player.shield = false;
+            break;
+
+        case DESPAWN_EVENT:
+            game.expired.insert(fired[i].payload);
+            break;
+        }
+    }
+
+    if (game.expired.empty())
+        return;
+
+    // entities that were already picked up or saved with their chunk are simply not found
+    for (size_t a = 0; a < game.spawner.archetypes.size(); a++)
+    {
+        entity_store &entities = game.spawner.archetypes[a].entities;
+
+        for (size_t i = 0; i < entity_count(entities); i++)
+        {
+            if (game.expired.count(entities.id[i]))
+                entities.dead[i] = true;
+        }
+    }
+    game.expired.clear();
+}
+
+// every world needs its own cache folder, even when games run at the same time
+atomic<uint64_t> worlds_created(0);
+
+game_data new_game(bool headless, uint64_t seed)
+{
+    game_data new_game;
+
+    new_game.headless = headless;
+    new_game.rng = new_rng(seed);
+    new_game.ticks = 0;
+    new_game.player = new_player(not headless);
+    new_game.player.shield = false;
+    new_game.player.shield_count = 0;
+    new_game.player.game_over = false;
+    new_game.player.fuel_pct = 1;
+    new_game.player.score = 0;
+    new_game.game_over_by = 1;
+    new_game.world = new_world(worlds_created++);
+    new_game.systems = new_game_systems(false);
+    new_game.spawner.next_id = 1;
+    new_game.spawner.static_changes = 0;
+    new_game.static_built = 0;
+    new_game.timers = new_timer_wheel();
+    new_game.projectiles = new_projectile_pool(PROJECTILE_POOL_SIZE);
+    fill(begin(new_game.fire_ready), end(new_game.fire_ready), 0);
+    new_game.particles = new_particle_system(headless ? 0 : PARTICLE_CAPACITY);
+    new_game.gravity = new_gravity_field(rng_next(new_game.rng));
+    new_game.hunt = new_flow_field(GRAVITY_ACTIVE_SIDE * CHUNK_SIZE / FLOW_CELL, GRAVITY_ACTIVE_SIDE * CHUNK_SIZE / FLOW_CELL, FLOW_CELL);
+    new_game.swarm = false;
+    new_game.flock = new_flock();
+    new_game.impostors = headless ? new_impostor_batch(0, 0) : new_impostor_batch(WINDOW_WIDTH, WINDOW_HEIGHT);
+    new_game.pool = nullptr;
+    update_spatial_indexes(new_game);
+
+    schedule_next_spawn(new_game);
+
+    return new_game;
+}
+
+worker_pool *game_pool(const game_data &game)
+{
+    return game.pool;
+}
+
+void start_swarm(game_data &game)
+{
+    game.swarm = true;
+    game.systems = new_game_systems(true);
+
+    point_2d center = player_center(game.player);
+    float reach = (ACTIVE_CHUNK_RADIUS + 0.5f) * CHUNK_SIZE;
+
+    // the swarm starts in a ring, so the player has a moment before it closes in
+    for (int i = 0; i < SWARM_FOES; i++)
+    {
+        float angle = rng_float(game.rng) * 2 * M_PI;
+        float distance = SWARM_MIN_DISTANCE + rng_float(game.rng) * (reach - SWARM_MIN_DISTANCE);
+        spawn_into(game.spawner, entity_spawn(FOE, center.x + cos(angle) * distance, center.y + sin(angle) * distance, game.rng));
+    }
+}
+
+void free_game(game_data &game)
+{
+    free_world(game.world, game.spawner);
+    free_timer_wheel(game.timers);
+}
+
+/**
+ * draws the entities, projectiles and player as impostors, for a camera
+ * zoomed out too far to make out their bitmaps. the player goes last so
+ * it is never covered
+ */
+void draw_game_impostors(game_data &game, const rectangle &view)
+{
+    impostor_batch &batch = game.impostors;
+    float zoom = game.player.zoom;
+    clear_impostors(batch);
+
+    for (size_t a = 0; a < game.spawner.archetypes.size(); a++)
+    {
+        const entity_store &entities = game.spawner.archetypes[a].entities;
+        for (size_t i = 0; i < entity_count(entities); i++)
+        {
+            if (not entities.dead[i])
+                add_impostor(batch, view, zoom, entities.x[i] + entities.width[i] / 2, entities.y[i] + entities.height[i] / 2, entities.minimap_color[i]);
+        }
+    }
+
+    const projectile_pool &pool = game.projectiles;
+    for (size_t n = 0; n < pool.count; n++)
+    {
+        size_t slot = (pool.head + n) & pool.mask;
+        if (pool.alive[slot])
+            add_impostor(batch, view, zoom, pool.x[slot], pool.y[slot], COLOR_YELLOW);
+    }
+
+    point_2d center = player_center(game.player);
+    add_impostor(batch, view, zoom, center.x, center.y, COLOR_WHITE);
+
+    build_impostor_runs(batch);
+    draw_impostors(batch, game.frame);
+}
+
+/**
+ * draws the entities from first up to last, counted across all the archetypes
+ */
+void draw_entity_share(const game_data &game, size_t first, size_t last, const rectangle &view, render_list &frame)
+{
+    size_t start = 0;
+
+    for (size_t a = 0; a < game.spawner.archetypes.size() and start < last; a++)
+    {
+        const entity_store &entities = game.spawner.archetypes[a].entities;
+        size_t count = entity_count(entities);
+
+        if (start + count > first)
+            draw_entities(entities, max(first, start) - start, min(last, start + count) - start, view, game.player.zoom, frame);
+        start += count;
+    }
+}
+
+/**
+ * draws every entity into the frame. a crowded view is split over the game's
+ * pool, each share recording its own list, and the lists are added to the
+ * frame in order, so the frame is the same as if one thread recorded it
+ */
+void draw_all_entities(game_data &game, const rectangle &view)
+{
+    size_t total = total_entities(game.spawner);
+    size_t shares = min(pool_threads(game.pool), total / RENDER_PARALLEL_MIN);
+
+    if (shares <= 1)
+    {
+        draw_entity_share(game, 0, total, view, game.frame);
+        return;
+    }
+
+    game.worker_frames.resize(shares);
+    size_t per_share = (total + shares - 1) / shares;
+
+    run_on_pool(game.pool, shares, [&](size_t t)
+    {
+        clear_render_list(game.worker_frames[t]);
+        draw_entity_share(game, t * per_share, min(total, (t + 1) * per_share), view, game.worker_frames[t]);
+    });
+
+    for (size_t t = 0; t < shares; t++)
+    {
+        append_render_list(game.frame, game.worker_frames[t]);
+    }
+}
+
+void draw_game(game_data &game_draw)
+{
+    render_list &frame = game_draw.frame;
+    clear_render_list(frame);
+
+    rectangle view = player_view(game_draw.player);
+    float zoom = game_draw.player.zoom;
+    draw_planets(game_draw.gravity, view, zoom, frame);
+
+    if (zoom < IMPOSTOR_ZOOM)
+    {
+        draw_game_impostors(game_draw, view);
+        return;
+    }
+
+    draw_player(game_draw.player, frame);
+    draw_all_entities(game_draw, view);
+    draw_projectiles(game_draw.projectiles, view, zoom, frame);
+
+    // zoomed out the particles would be lost under the ships, so they are only drawn at full size
+    if (zoom == 1)
+        draw_particles(game_draw.particles, view, frame);
+}
+
+void update_game(game_data &game_update)
+{
+    game_update.ticks++;
+
+    // spawns, shield expiry and despawns happen on the timer wheel
+    handle_timer_events(game_update);
+
+    // the grids must be ready before the systems sample them side by side
+    prepare_gravity(game_update.gravity, player_center(game_update.player));
+    apply_player_gravity(game_update);
+
+    // the hunt covers the same chunks as the gravity grids, around the same planets
+    if (game_update.hunt.left != game_update.gravity.left or game_update.hunt.top != game_update.gravity.top)
+        place_flow_field(game_update.hunt, game_update.gravity.left, game_update.gravity.top, game_update.gravity.planets);
+    update_flow_field(game_update.hunt, player_center(game_update.player));
+    gather_crowd(game_update.hunt, game_update.spatial);
+
+    update_player(game_update.player);
+    update_fuel(game_update);
+    apply_pickup_magnet(game_update);
+
+    run_systems(game_update.systems, game_update, game_update.spawner);
+
+    // power ups and hits are applied here as they play sounds and change the player sprite
+    for (size_t i = 0; i < game_update.pickups.size(); i++)
+    {
+        apply_spawn(game_update, game_update.pickups[i]);
+    }
+    for (size_t i = 0; i < game_update.static_pickups.size(); i++)
+    {
+        apply_spawn(game_update, game_update.static_pickups[i]);
+    }
+    for (size_t i = 0; i < game_update.hits.size(); i++)
+    {
+        apply_spawn(game_update, game_update.hits[i]);
+    }
+    game_update.pickups.clear();
+    game_update.static_pickups.clear();
+    game_update.hits.clear();
+
+    update_world(game_update.world, game_update.spawner, player_center(game_update.player), game_update.rng);
+
+    // picked up and saved entities leave together
+    remove_dead_entities(game_update.spawner);
+
+    update_spatial_indexes(game_update);
+
+    // projectiles sweep the grid that was just built, the foes they destroy leave in the next update
+    int destroyed = update_projectiles(game_update.projectiles, game_update.spatial, game_update.spawner);
+    game_update.player.score += destroyed * FOE_DESTROYED_SCORE;
+
+    const vector<point_2d> &wrecks = game_update.projectiles.wrecks;
+    for (size_t i = 0; i < wrecks.size(); i++)
+    {
+        emit_particles(game_update.particles, EXPLOSION, wrecks[i].x, wrecks[i].y);
+    }
+    update_particles(game_update.particles);
+}
+
+void fire_player_projectile(game_data &game, projectile_kind kind, const point_2d &target)
+{
+    if (game.ticks < game.fire_ready[kind])
+        return;
+
+    point_2d centre = player_center(game.player);
+    fire_projectile(game.projectiles, kind, centre.x, centre.y, target.x - centre.x, target.y - centre.y);
+    game.fire_ready[kind] = game.ticks + PROJECTILE_ARCHETYPES[kind].cooldown;
+}
+
+void handle_fire_input(game_data &game)
+{
+    // the window looks through the player's camera, so the mouse is this far into the world
+    // from the middle of the screen, further when zoomed out
+    point_2d mouse = mouse_position();
+    double middle_x = game.player.camera.x + WINDOW_WIDTH / 2, middle_y = game.player.camera.y + WINDOW_HEIGHT / 2;
+    point_2d target = point_at(middle_x + (mouse.x - WINDOW_WIDTH / 2) / game.player.zoom, middle_y + (mouse.y - WINDOW_HEIGHT / 2) / game.player.zoom);
+
+    if (key_down(SPACE_KEY))
+        fire_player_projectile(game, BULLET, target);
+    if (key_down(B_KEY))
+        fire_player_projectile(game, BOMB, target);
+}
+
+//                                      ●▬▬▬▬   »»»       autopilot.𝗵       «««  ▬▬▬▬▬●
+
+#define BOT_AVOID_RADIUS 300
+#define BOT_AVOID_WEIGHT 2.0
+#define BOT_LOW_FUEL 0.35
+#define BOT_MAX_SESSION_SECONDS 3600
+#define BOT_FIRE_RANGE 500
+
+/**
+ * Plays the game instead of the mouse: heads for the nearest pickup
+ * (fuel first when the tank runs low), turns away from foes that come
+ * close and stops when there is nothing worth moving for. It moves the
+ * player through steer_player and stop_player just like handle_input.
+ * 
+ * @param game  the game being played
+ */
+void autopilot_input(game_data &game);
+
+/**
+ * Plays a headless game with the autopilot until it is over,
+ * or until it has lasted BOT_MAX_SESSION_SECONDS of game time.
+ * 
+ * @param game  a game made with new_game(true, ...)
+ */
+void play_bot_game(game_data &game);
+
+//                                      ●▬▬▬▬   »»»       autopilot.cpp       «««  ▬▬▬▬▬●
+
+void autopilot_input(game_data &game)
+{
+    point_2d centre = player_center(game.player);
+    bool low_fuel = game.player.fuel_pct < BOT_LOW_FUEL;
+
+    double best = -1, closest_foe = BOT_FIRE_RANGE * BOT_FIRE_RANGE;
+    point_2d target = centre, foe = centre;
+    vector_2d away = vector_to(0, 0);
+
+    for (size_t a = 0; a < game.spawner.archetypes.size(); a++)
+    {
+        const archetype_data &archetype = game.spawner.archetypes[a];
+        bool hostile = archetype_matches(archetype, HOSTILE, 0);
+
+        if (not hostile and not archetype_matches(archetype, PICKUP, 0))
+            continue;
+
+        const entity_store &entities = archetype.entities;
+        for (size_t i = 0; i < entity_count(entities); i++)
+        {
+            if (entities.dead[i])
+                continue;
+
+            double ex = entities.x[i] + entities.width[i] / 2 - centre.x;
+            double ey = entities.y[i] + entities.height[i] / 2 - centre.y;
+            double dist_sq = ex * ex + ey * ey;
+
+            if (hostile)
+            {
+                if (dist_sq < closest_foe)
+                {
+                    closest_foe = dist_sq;
+                    foe = point_at(ex + centre.x, ey + centre.y);
+                }
+
+                // foes push harder the closer they are
+                if (dist_sq < BOT_AVOID_RADIUS * BOT_AVOID_RADIUS and dist_sq > 0)
+                {
+                    double dist = sqrt(dist_sq);
+                    double push = (BOT_AVOID_RADIUS - dist) / BOT_AVOID_RADIUS;
+                    away.x -= ex / dist * push;
+                    away.y -= ey / dist * push;
+                }
+                continue;
+            }
+
+            // fuel looks three times closer when the tank runs low
+            if (low_fuel and ENTITY_ARCHETYPES[entities.type[i]].fuel > 0)
+                dist_sq /= 9;
+
+            if (best < 0 or dist_sq < best)
+            {
+                best = dist_sq;
+                target = point_at(ex + centre.x, ey + centre.y);
+            }
+        }
+    }
+
+    vector_2d heading = vector_to(0, 0);
+    if (best >= 0)
+        heading = unit_vector(vector_point_to_point(centre, target));
+
+    heading.x += away.x * BOT_AVOID_WEIGHT;
+    heading.y += away.y * BOT_AVOID_WEIGHT;
+
+    // same as holding space with the mouse on the closest foe
+    if (closest_foe < BOT_FIRE_RANGE * BOT_FIRE_RANGE)
+        fire_player_projectile(game, BULLET, foe);
+
+    // same as clicking the right button
+    if (vector_magnitude(heading) < 0.01)
+    {
+        stop_player(game.player);
+        return;
+    }
+
+    // same as holding the left button with the mouse in that direction
+    steer_player(game.player, point_at(centre.x + heading.x * 100, centre.y + heading.y * 100));
+}
+
+void play_bot_game(game_data &game)
+{
+    while (not game.player.game_over and game.ticks < BOT_MAX_SESSION_SECONDS * TICKS_PER_SECOND)
+    {
+        autopilot_input(game);
+        update_game(game);
+    }
+}
+
+//                                      ●▬▬▬▬   »»»       soak.𝗵       «««  ▬▬▬▬▬●
+
+#define SOAK_DEFAULT_SESSIONS 1000
+#define SOAK_MIN_SESSIONS 8
+#define SOAK_RSS_SLACK_KB 4096
+
+/**
+ * What was left over after each game of a soak run, to find resources
+ * that are not given back when a game ends.
+ * 
+ * @field   samples     the ledger and memory after each game was freed
+ */
+struct soak_data
+{
+    vector<resource_counts> samples;
+};
+
+/**
+ * Records what is still alive after a game has been freed.
+ * 
+ * @param soak  the soak run
+ */
+void record_soak_sample(soak_data &soak);
+
+/**
+ * Writes the soak report and checks that nothing grew. The first tenth
+ * of the games is a warm up, then the highest count in the first quarter
+ * of the rest is compared with the highest in the last quarter.
+ * 
+ * @param soak  the soak run
+ * @return      false if a count or the memory kept growing
+ */
+bool soak_passed(const soak_data &soak);
+
+//                                      ●▬▬▬▬   »»»       soak.cpp       «««  ▬▬▬▬▬●
+
+void record_soak_sample(soak_data &soak)
+{
+    soak.samples.push_back(current_resources());
+}
+
+/**
+ * writes one line of the report and checks one count
+ * 
+ * @param name      what is counted
+ * @param counts    the count after each game
+ * @param slack     how much the count may grow without being a leak
+ * @return          false if the count grew
+ */
+bool soak_check(const string &name, const vector<long> &counts, long slack)
+{
+    size_t warm_up = counts.size() / 10;
+    size_t quarter = max((size_t)1, (counts.size() - warm_up) / 4);
+
+    long early = *max_element(counts.begin() + warm_up, counts.begin() + warm_up + quarter);
+    long late = *max_element(counts.end() - quarter, counts.end());
+    bool grew = late > early + slack;
+
+    write_line(name + ": first " + to_string(counts.front()) + ", early peak " + to_string(early) + ", late peak " + to_string(late) + ", last " + to_string(counts.back()) + (grew ? "  GROWING" : "  ok"));
+
+    return not grew;
+}
+
+bool soak_passed(const soak_data &soak)
+{
+    write_line("soak report: " + to_string(soak.samples.size()) + " sessions");
+
+    if (soak.samples.size() < SOAK_MIN_SESSIONS)
+    {
+        write_line("too few sessions to tell if anything grows");
+        return true;
+    }
+
+    vector<long> sprites, bitmaps, sounds, timers, rss;
+    for (size_t i = 0; i < soak.samples.size(); i++)
+    {
+        sprites.push_back(soak.samples[i].sprites);
+        bitmaps.push_back(soak.samples[i].bitmaps);
+        sounds.push_back(soak.samples[i].sounds);
+        timers.push_back(soak.samples[i].timers);
+        rss.push_back(soak.samples[i].rss_kb);
+    }
+
+    // every check runs so the report is complete
+    bool passed = soak_check("sprites", sprites, 0);
+    passed = soak_check("bitmaps", bitmaps, 0) and passed;
+    passed = soak_check("sounds", sounds, 0) and passed;
+    passed = soak_check("timers", timers, 0) and passed;
+    passed = soak_check("rss kb", rss, SOAK_RSS_SLACK_KB) and passed;
+
+    write_line(passed ? "soak passed" : "soak FAILED");
+    return passed;
+}
+
+//                                      ●▬▬▬▬   »»»       balance.𝗵       «««  ▬▬▬▬▬●
+
+/**
+ * How one game played by the autopilot ended.
+ * 
+ * @field   score       the final score
+ * @field   seconds     game time survived
+ * @field   ended_by    0 when time ran out, otherwise the game's game_over_by
+ */
+struct balance_result
+{
+    int score;
+    double seconds;
+    int ended_by;
+};
+
+/**
+ * Plays many headless games with the autopilot, spread over threads, to
+ * see how the spawn weights play out. Game i uses seed + i, so the same
+ * seed gives the same results on any number of threads.
+ * 
+ * @param games     number of games to play
+ * @param threads   threads to use, 0 for one per core
+ * @param seed      seed of the first game
+ * @return          the result of every game, in game order
+ */
+vector<balance_result> play_balance_games(int games, int threads, uint64_t seed);
+
+/**
+ * Plays the games and writes the score, survival time and game over
+ * distributions.
+ */
+void run_balance(int games, int threads, uint64_t seed);
+
+//                                      ●▬▬▬▬   »»»       balance.cpp       «««  ▬▬▬▬▬●
+
+vector<balance_result> play_balance_games(int games, int threads, uint64_t seed)
+{
+    vector<balance_result> results(games);
+    atomic<int> next_game(0);
+
+    if (threads <= 0)
+        threads = max(1u, thread::hardware_concurrency());
+
+    // each thread takes the next game until there are none left
+    auto worker = [&]()
+    {
+        for (int i = next_game++; i < games; i = next_game++)
+        {
+            game_data game = new_game(true, seed + i);
+            play_bot_game(game);
+
+            results[i].score = game.player.score;
+            results[i].seconds = (double)game.ticks / TICKS_PER_SECOND;
+            results[i].ended_by = game.player.game_over ? game.game_over_by : 0;
+
+            free_game(game);
+        }
+    };
+
+    vector<thread> workers;
+    for (int t = 1; t < threads; t++)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+
+    for (size_t t = 0; t < workers.size(); t++)
+    {
+        workers[t].join();
+    }
+
+    return results;
+}
+
+/**
+ * writes the mean and percentiles of a list of values
+ */
+void write_distribution(const string &name, vector<double> values)
+{
+    sort(values.begin(), values.end());
+
+    double total = 0;
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        total += values[i];
+    }
+
+    // nearest rank percentile
+    auto at = [&](double p)
+    {
+        return to_string((int)values[(size_t)(p * (values.size() - 1) + 0.5)]);
+    };
+
+    write_line(name + ": mean " + to_string((int)(total / values.size())) + ", min " + at(0) + ", p10 " + at(0.1) + ", p25 " + at(0.25) + ", median " + at(0.5) + ", p75 " + at(0.75) + ", p90 " + at(0.9) + ", max " + at(1));
+}
+
+void run_balance(int games, int threads, uint64_t seed)
+{
+    auto start = chrono::steady_clock::now();
+    vector<balance_result> results = play_balance_games(games, threads, seed);
+    double took = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    vector<double> scores, seconds;
+    int ended[3] = {0, 0, 0};
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        scores.push_back(results[i].score);
+        seconds.push_back(results[i].seconds);
+        ended[results[i].ended_by]++;
+    }
+
+    write_line("balance: " + to_string(games) + " games from seed " + to_string(seed) + " in " + to_string((int)took) + "s");
+    write_distribution("score", scores);
+    write_distribution("survived (s)", seconds);
+
+    const string names[3] = {"time up", "hit by a foe", "out of fuel"};
+    for (int i = 0; i < 3; i++)
+    {
+        write_line(names[i] + ": " + to_string(ended[i]) + " (" + to_string(100 * ended[i] / games) + "%)");
+    }
+}
+
+//                                      ●▬▬▬▬   »»»       environment.𝗵       «««  ▬▬▬▬▬●
+
+#define ENV_NEAREST 8
+#define ENV_PLAYER_FEATURES 6
+#define ENV_ENTITY_FEATURES 7
+#define ENV_OBSERVATION_SIZE (ENV_PLAYER_FEATURES + ENV_NEAREST * ENV_ENTITY_FEATURES)
+#define ENV_ACTION_SIZE 2
+#define ENV_VIEW_RANGE 1000.0f
+#define ENV_PARALLEL_MIN 64
+
+/**
+ * A batch of independent headless games stepped together, for training
+ * agents. Build with SPACE_WARS_LIBRARY defined to leave out main() and
+ * use the batch from C (or Python through ctypes/cffi).
+ * 
+ * Every observation is ENV_OBSERVATION_SIZE floats:
+ *  - the player: dx, dy (over MAX_VEL), fuel_pct, shield, x, y (over CHUNK_SIZE)
+ *  - the ENV_NEAREST closest entities, closest first, each one:
+ *    x, y from the player (over ENV_VIEW_RANGE), dx, dy (over MAX_VEL),
+ *    hostile, fuel and 1 for a used slot. Unused slots are all 0.
+ * Every action is ENV_ACTION_SIZE floats: the direction to fly in,
+ * a direction shorter than 0.01 stops the player.
+ * 
+ * @field   games       the games, one per environment
+ * @field   episodes    how many games each environment has finished
+ * @field   pool        threads to step the games on, started with the batch and
+ *                      also lent to the games when the batch is stepped on one thread
+ * @field   seed        seed of the first game of environment 0
+ */
+struct env_batch
+{
+    vector<game_data> games;
+    vector<unsigned long long> episodes;
+    worker_pool *pool;
+    uint64_t seed;
+};
+
+extern "C"
+{
+    /**
+     * Creates a batch of games.
+     * 
+     * @param count     number of environments
+     * @param threads   threads to step them on, 0 for one per core
+     * @param seed      seed for the games, every game gets its own seed from it
+     */
+    env_batch *new_env_batch(int count, int threads, uint64_t seed);
+
+    /**
+     * @return  the number of floats in one observation
+     */
+    int env_observation_size();
+
+    /**
+     * Starts a new game in every environment.
+     * 
+     * @param observations  count * ENV_OBSERVATION_SIZE floats, filled in
+     */
+    void reset_env_batch(env_batch *batch, float *observations);
+
+    /**
+     * Moves every environment on by one tick. An environment whose game
+     * ended gets done set and starts a new game straight away, its
+     * observation is then the first of the new game.
+     * 
+     * @param actions       count * ENV_ACTION_SIZE floats
+     * @param observations  count * ENV_OBSERVATION_SIZE floats, filled in
+     * @param rewards       count floats, the score gained this tick
+     * @param dones         count bytes, 1 when the game ended this tick
+     */
+    void step_env_batch(env_batch *batch, const float *actions, float *observations, float *rewards, uint8_t *dones);
+
+    /**
+     * Frees the games and the batch.
+     */
+    void free_env_batch(env_batch *batch);
+}
+
+//                                      ●▬▬▬▬   »»»       environment.cpp       «««  ▬▬▬▬▬●
+
+/**
+ * seed of an environment's next game, the same whatever the thread count
+ */
+uint64_t env_game_seed(const env_batch &batch, size_t env)
+{
+    return batch.seed + env + batch.episodes[env] * batch.games.size();
+}
+
+/**
+ * writes the observation of one game
+ */
+void observe_game(game_data &game, float *observation)
+{
+    const player_data &player = game.player;
+    point_2d centre = player_center(player);
+
+    observation[0] = player.dx / MAX_VEL;
+    observation[1] = player.dy / MAX_VEL;
+    observation[2] = player.fuel_pct;
+    observation[3] = player.shield ? 1 : 0;
+    observation[4] = centre.x / CHUNK_SIZE;
+    observation[5] = centre.y / CHUNK_SIZE;
+
+    float *slots = observation + ENV_PLAYER_FEATURES;
+    fill(slots, slots + ENV_NEAREST * ENV_ENTITY_FEATURES, 0.0f);
+
+    // the grids were updated at the end of the update, the closest of both are merged
+    vector<spatial_hit> &nearest = game.nearby;
+    vector<spatial_hit> &nearest_static = game.nearby_static;
+    spatial_nearest(game.spatial, centre.x, centre.y, ENV_NEAREST, 0, nearest);
+    spatial_nearest(game.static_spatial, centre.x, centre.y, ENV_NEAREST, 0, nearest_static);
+
+    auto closer = [](const spatial_hit &a, const spatial_hit &b) { return a.distance < b.distance; };
+    nearest.insert(nearest.end(), nearest_static.begin(), nearest_static.end());
+    inplace_merge(nearest.begin(), nearest.end() - nearest_static.size(), nearest.end(), closer);
+    nearest.resize(min(nearest.size(), (size_t)ENV_NEAREST));
+
+    for (size_t n = 0; n < nearest.size(); n++)
+    {
+        const entity_store &entities = game.spawner.archetypes[ref_archetype(nearest[n].ref)].entities;
+        size_t i = ref_index(nearest[n].ref);
+        const entity_archetype &archetype = ENTITY_ARCHETYPES[entities.type[i]];
+        float *slot = slots + n * ENV_ENTITY_FEATURES;
+
+        slot[0] = (entities.x[i] + entities.width[i] / 2 - centre.x) / ENV_VIEW_RANGE;
+        slot[1] = (entities.y[i] + entities.height[i] / 2 - centre.y) / ENV_VIEW_RANGE;
+        slot[2] = entities.dx[i] / MAX_VEL;
+        slot[3] = entities.dy[i] / MAX_VEL;
+        slot[4] = (archetype.components & HOSTILE) ? 1 : 0;
+        slot[5] = archetype.fuel > 0 ? 1 : 0;
+        slot[6] = 1;
+    }
+}
+
+/**
+ * steers the player the way the action says
+ */
+void apply_action(game_data &game, const float *action)
+{
+    if (action[0] * action[0] + action[1] * action[1] < 0.0001f)
+    {
+        stop_player(game.player);
+        return;
+    }
+
+    point_2d centre = player_center(game.player);
+    steer_player(game.player, point_at(centre.x + action[0] * 100, centre.y + action[1] * 100));
+}
+
+/**
+ * runs work(first, last) over ranges of the environments on the batch's pool
+ */
+void for_each_env_range(const env_batch &batch, const function<void(size_t, size_t)> &work)
+{
+    size_t count = batch.games.size();
+
+    // a few games step faster than the work is handed out
+    size_t shares = max((size_t)1, min(pool_threads(batch.pool), count / ENV_PARALLEL_MIN));
+    size_t per_share = (count + shares - 1) / shares;
+
+    run_on_pool(batch.pool, shares, [&](size_t t)
+    {
+        work(t * per_share, min(count, (t + 1) * per_share));
+    });
+}
+
+/**
+ * starts the next game of an environment. the games can split their own
+ * updates over the pool, which only happens when the batch is not already
+ * running on it
+ */
+game_data new_env_game(const env_batch &batch, size_t env)
+{
+    game_data result = new_game(true, env_game_seed(batch, env));
+    result.pool = batch.pool;
+    return result;
+}
+
+env_batch *new_env_batch(int count, int threads, uint64_t seed)
+{
+    env_batch *result = new env_batch;
+
+    result->pool = new_worker_pool(threads);
+    result->seed = seed;
+    result->episodes.assign(count, 0);
+
+    for (int i = 0; i < count; i++)
+    {
+        result->games.push_back(new_env_game(*result, i));
+    }
+
+    return result;
+}
+
+int env_observation_size()
+{
+    return ENV_OBSERVATION_SIZE;
+}
+
+void reset_env_batch(env_batch *batch, float *observations)
+{
+    for_each_env_range(*batch, [&](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; i++)
+        {
+            free_game(batch->games[i]);
+            batch->episodes[i]++;
+            batch->games[i] = new_env_game(*batch, i);
+            observe_game(batch->games[i], observations + i * ENV_OBSERVATION_SIZE);
+        }
+    });
+}
+
+void step_env_batch(env_batch *batch, const float *actions, float *observations, float *rewards, uint8_t *dones)
+{
+    for_each_env_range(*batch, [&](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; i++)
+        {
+            game_data &game = batch->games[i];
+            int score = game.player.score;
+
+            apply_action(game, actions + i * ENV_ACTION_SIZE);
+            update_game(game);
+
+            rewards[i] = game.player.score - score;
+            dones[i] = game.player.game_over or game.ticks >= BOT_MAX_SESSION_SECONDS * TICKS_PER_SECOND;
+
+            if (dones[i])
+            {
+                free_game(game);
+                batch->episodes[i]++;
+                game = new_env_game(*batch, i);
+            }
+
+            observe_game(game, observations + i * ENV_OBSERVATION_SIZE);
+        }
+    });
+}
+
+void free_env_batch(env_batch *batch)
+{
+    for (size_t i = 0; i < batch->games.size(); i++)
+    {
+        free_game(batch->games[i]);
+    }
+    free_worker_pool(batch->pool);
+    delete batch;
+}
+
+/**
+ * Steps a batch of environments with the autopilot's moves replaced by
+ * random ones and writes how many steps it managed per millisecond.
+ */
+void run_env_benchmark(int count, int threads, uint64_t seed)
+{
+    const int steps = 2000;
+
+    env_batch *batch = new_env_batch(count, threads, seed);
+    vector<float> observations(count * ENV_OBSERVATION_SIZE);
+    vector<float> actions(count * ENV_ACTION_SIZE);
+    vector<float> rewards(count);
+    vector<uint8_t> dones(count);
+    game_rng rng = new_rng(seed);
+
+    for (size_t i = 0; i < actions.size(); i++)
+    {
+        actions[i] = rng_float(rng) * 2 - 1;
+    }
+
+    reset_env_batch(batch, observations.data());
+
+    auto start = chrono::steady_clock::now();
+    for (int s = 0; s < steps; s++)
+    {
+        step_env_batch(batch, actions.data(), observations.data(), rewards.data(), dones.data());
+    }
+    double took = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    write_line(to_string(count) + " environments, " + to_string(pool_threads(batch->pool)) + " threads: " + to_string((int)(count * steps / took)) + " steps per ms");
+    free_env_batch(batch);
+}
+
+//                                      ●▬▬▬▬   »»»       program.cpp       «««  ▬▬▬▬▬●
+
+/**
+ * The options the game was started with.
+ * 
+ * @field   bot         the autopilot plays instead of the mouse (--bot)
+ * @field   headless    play with the autopilot and no window as fast as possible (--headless)
+ * @field   sessions    stop after this many games, 0 to keep going (--sessions N)
+ * @field   minutes     stop starting new games after this many minutes, 0 to keep going (--minutes N)
+ * @field   soak        play games with the autopilot back to back and check nothing leaks (--soak)
+ * @field   balance     play this many headless games at once and report how they went (--balance N)
+ * @field   threads     threads for the game's own updates, --balance and the env and boids benchmarks, 0 for one per core (--threads N)
+ * @field   seed        random seed of the first game, the next games count up from it (--seed N)
+ * @field   swarm       play the swarm mode, where thousands of foes flock together (--swarm)
+ * @field   bench       name of the benchmark to run instead of the game, see BENCHMARKS (--bench NAME N)
+ * @field   bench_count how many things the benchmark times, the N of --bench
+ * @field   check       check parts of the game against brute force, see CHECKS (--check)
+ * @field   frame_stats     file the frame jitter and input latency histograms are written to, empty for none (--frame-stats PATH)
+ */
+struct program_options
+{
+    bool bot;
+    bool headless;
+    bool soak;
+    int sessions;
+    double minutes;
+    int balance;
+    int threads;
+    uint64_t seed;
+    bool swarm;
+    string bench;
+    int bench_count;
+    bool check;
+    string frame_stats;
+};
+
+/**
+ * Reads the options from the command line.
+ */
+program_options read_options(int argc, char *argv[])
+{
+    program_options result;
+    result.bot = false;
+    result.headless = false;
+    result.soak = false;
+    result.sessions = 0;
+    result.minutes = 0;
+    result.balance = 0;
+    result.threads = 0;
+    result.swarm = false;
+    result.bench = "";
+    result.bench_count = 0;
+    result.check = false;
+    result.frame_stats = "";
+    result.seed = chrono::steady_clock::now().time_since_epoch().count();
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+
+        if (arg == "--bot")
+            result.bot = true;
+        else if (arg == "--headless")
+            result.bot = result.headless = true;
+        else if (arg == "--soak")
+            result.bot = result.soak = true;
+        else if (arg == "--sessions" and i + 1 < argc)
+            result.sessions = stoi(argv[++i]);
+        else if (arg == "--minutes" and i + 1 < argc)
+            result.minutes = stod(argv[++i]);
+        else if (arg == "--balance" and i + 1 < argc)
+            result.balance = stoi(argv[++i]);
+        else if (arg == "--threads" and i + 1 < argc)
+            result.threads = stoi(argv[++i]);
+        else if (arg == "--swarm")
+            result.swarm = true;
+        else if (arg == "--bench" and i + 2 < argc)
+        {
+            result.bench = argv[++i];
+            result.bench_count = stoi(argv[++i]);
+        }
+        else if (arg == "--check")
+            result.check = true;
+        else if (arg == "--frame-stats" and i + 1 < argc)
+            result.frame_stats = argv[++i];
+        else if (arg == "--seed" and i + 1 < argc)
+            result.seed = stoull(argv[++i]);
+        else
+            write_line("unknown option " + arg);
+    }
+
+    // a soak run has to end to give its report
+    if (result.soak and result.sessions == 0 and result.minutes == 0)
+        result.sessions = SOAK_DEFAULT_SESSIONS;
+
+    return result;
+}
+
+/**
+ * one line about how a game played by the autopilot went
+ */
+string session_summary(const game_data &game, int session)
+{
+    string ending = not game.player.game_over ? "time up" : game.game_over_by == 2 ? "out of fuel" : "hit by a foe";
+
+    return "session " + to_string(session) + ": score " + to_string(game.player.score) + ", " + to_string(game.ticks / TICKS_PER_SECOND) + "s, " + ending;
+}
+
+/**
+ * checks if the options say no more games should be started
+ */
+bool sessions_done(const program_options &options, int played, chrono::steady_clock::time_point start)
+{
+    double minutes = chrono::duration<double>(chrono::steady_clock::now() - start).count() / 60;
+
+    return (options.sessions > 0 and played >= options.sessions) or (options.minutes > 0 and minutes >= options.minutes);
+}
+
+/**
+ * Plays games with the autopilot without opening a window,
+ * as fast as the computer allows.
+ * 
+ * @return  the exit code, 1 when a soak run found a leak
+ */
+int run_headless(const program_options &options)
+{
+    load_spawn_table();
+
+    soak_data soak;
+    worker_pool *pool = new_worker_pool(options.threads);
+
+    auto start = chrono::steady_clock::now();
+    int played = 0;
+
+    while (not sessions_done(options, played, start))
+    {
+        // picks up changes to the spawn weights between games
+        reload_spawn_table();
+
+        game_data game = new_game(true, options.seed + played);
+        game.pool = pool;
+        if (options.swarm)
+            start_swarm(game);
+        play_bot_game(game);
+
+        played++;
+        write_line(session_summary(game, played));
+        free_game(game);
+
+        if (options.soak)
+            record_soak_sample(soak);
+    }
+
+    free_worker_pool(pool);
+
+    if (options.soak and not soak_passed(soak))
+        return 1;
+    return 0;
+}
+
+/**
+ * Load the game images, sounds, etc.
+ * also text for hud.
+ */
+void load_resources()
+{
+    load_resource_bundle("game_bundle", "space_wars.txt");
+    count_bundle_resources("space_wars.txt", 1);
+    load_player_bitmaps();
+    load_entity_bitmaps();
+    load_projectile_bitmaps();
+    load_planet_bitmaps();
+    load_spawn_table();
+}
+
+/**
+ * this is used to simplify the location to integer values
+ * for easier display on screen. 
+ * 
+ * @param player    the player whose location is checked
+ * @return          string with location of player for hud
+ */
+string loc_to_string(const player_data &player)
+{
+    point_2d location = player_center(player);
+    int x, y;
+    x = (int)location.x;
+    y = (int)location.y;
+    return to_string(x) + " " + to_string(y);
+}
+
+/**
+ * this function is used to get the position of a specific entity
+ * relative to the size of the screen dimensions.
+ * 
+ * @param game      the main game variable used in various tasks
+ * @param entities  the entities the entity is in
+ * @param i         an integer used to know the index of entity in vector
+ * @return      the co-ordinates of certain entity relative to your screen size 
+ */
+point_2d spawn_mini_map_coordinate(const game_data &game, const entity_store &entities, size_t i)
+{
+    point_2d location = player_center(game.player);
+    int x, y;
+    x = (int)location.x;
+    y = (int)location.y;
+    double entity_x, entity_y, mini_map_x, mini_map_y;
+
+    entity_x = entities.x[i];
+    entity_y = entities.y[i];
+
+    // Calculating the coordinate of the entity according to the minimap
+    mini_map_x = (entity_x - x - MIN_SPAWN) / MAX_SPAWN_RANGE * 100 + 20;
+    mini_map_y = (entity_y - y - MIN_SPAWN) / MAX_SPAWN_RANGE * 100 + 20;
+
+    return point_at(mini_map_x, mini_map_y);
+}
+
+/**
+ * this procedure is used to draw a mini map in the game
+ * it also draws pixels for position of several entities and the player
+ * 
+ * @param game  The game details used for various tasks
+ */
+void draw_minimap(const game_data &game, render_list &frame)
+{
+    record_fill_rectangle(frame, LAYER_HUD_BACK, COLOR_BLACK, 20, 20, 100, 100);
+    record_rectangle(frame, LAYER_HUD, COLOR_WHITE, 20, 20, 100, 100);
+
+    for (size_t a = 0; a < game.spawner.archetypes.size(); a++)
+    {
+        const archetype_data &archetype = game.spawner.archetypes[a];
+        if (not archetype_matches(archetype, MINIMAP_COLOR, 0))
+            continue;
+
+        for (size_t i = 0; i < entity_count(archetype.entities); i++)
+        {
+            point_2d mini_map_pos = spawn_mini_map_coordinate(game, archetype.entities, i);
+
+            // active chunks reach further than the minimap shows
+            if (mini_map_pos.x < 20 or mini_map_pos.x > 120 or mini_map_pos.y < 20 or mini_map_pos.y > 120)
+                continue;
+
+            record_pixel(frame, LAYER_HUD_FRONT, archetype.entities.minimap_color[i], mini_map_pos.x, mini_map_pos.y);
+        }
+    }
+
+    //Drawing position of the player with white colour
+    record_pixel(frame, LAYER_HUD_FRONT, rgba_color(255, 255, 255, 255), 70, 70);
+}
+
+/**
+ * procedure to draw the force field sign
+ * on the hud to indicate that shield is active
+ * it depens on :-
+ * shield in struct player_data
+ */
+void shield_disp(const player_data &player_shield_display, render_list &frame)
+{
+    if (player_shield_display.shield)
+    {
+        record_bitmap(frame, LAYER_HUD, bitmap_named("force"), 65, 510, 1);
+    }
+}
+
+/**
+ * this procedure to display fuel in the hud
+ * the amount of fuel displayed depends on :-
+ *  
+ * fuel_pct in struct player_data
+ */
+void fuel_checker(game_data &game_player_fuel)
+{
+    render_list &frame = game_player_fuel.frame;
+    double part_width = game_player_fuel.player.fuel_pct * bitmap_width("full");
+
+    record_text(frame, LAYER_HUD, "FUEL: ", COLOR_BRIGHT_GREEN, "font", 25, 10, 555);
+    // the empty bar is over the hud's background and under the fuel left
+    record_bitmap(frame, LAYER_HUD_GAUGE, bitmap_named("empty"), 70, 550, 1);
+    // an empty tank would be a part with no width, which draws the whole bitmap
+    if (part_width > 0)
+        record_bitmap_part(frame, LAYER_HUD, bitmap_named("full"), 70, 550, part_width, bitmap_height("full"));
+}
+
+/**
+ * draws an arrow next to the player pointing at the nearest ally,
+ * once the ally is far enough away to be off the screen
+ */
+void draw_ally_arrow(game_data &game)
+{
+    point_2d centre = player_center(game.player);
+
+    spatial_nearest(game.static_spatial, centre.x, centre.y, 1, STATIC | PICKUP, game.nearby);
+    if (game.nearby.empty() or game.nearby[0].distance < WINDOW_HEIGHT / 2)
+        return;
+
+    const entity_store &allies = game.spawner.archetypes[ref_archetype(game.nearby[0].ref)].entities;
+    size_t ally = ref_index(game.nearby[0].ref);
+
+    // the direction to the ally, and the same turned a quarter for the width of the arrow
+    double ux = (allies.x[ally] + allies.width[ally] / 2 - centre.x) / game.nearby[0].distance;
+    double uy = (allies.y[ally] + allies.height[ally] / 2 - centre.y) / game.nearby[0].distance;
+    double sx = centre.x - game.player.camera.x, sy = centre.y - game.player.camera.y;
+
+    record_fill_triangle(game.frame, LAYER_HUD, MINIMAP_ALLY,
+                         sx + ux * 95, sy + uy * 95,
+                         sx + ux * 75 - uy * 10, sy + uy * 75 + ux * 10,
+                         sx + ux * 75 + uy * 10, sy + uy * 75 - ux * 10);
+}
+
+/**
+ * procedure to display the hud
+ * and all the features in it.
+ */
+void display_hub(game_data &game)
+{
+    // score of the player
+    record_text(game.frame, LAYER_HUD, "SCORE: " + to_string(game.player.score), COLOR_WHITE, "", 0, 1090, 590);
+
+    // location of the player
+    record_text(game.frame, LAYER_HUD, "LOCATION: " + loc_to_string(game.player), COLOR_WHITE, "", 0, screen_width() / 2 - 60, screen_height() - 15);
+
+    // background of hud display
+    record_bitmap(game.frame, LAYER_HUD_BACK, bitmap_named("hud"), 1, 490, 1);
+
+    fuel_checker(game);
+    shield_disp(game.player, game.frame);
+    // star_disp(game.player);
+
+    draw_minimap(game, game.frame);
+    draw_ally_arrow(game);
+}
+
+/**
+ * fills a game with count entities on the screen and times recording,
+ * sorting and drawing its frames. the calls are the splashkit draw calls
+ * really made, the runs are the draws sharing a bitmap or shape next to
+ * each other, which only a batching renderer could merge
+ */
+void run_render_benchmark(int count, uint64_t seed)
+{
+    game_data game = new_game(false, seed);
+    game.pool = new_worker_pool(0);
+    rectangle view = player_view(game.player);
+
+    for (int i = 0; i < count; i++)
+    {
+        spawn_into(game.spawner, entity_spawn(view.x + rng_float(game.rng) * view.width, view.y + rng_float(game.rng) * view.height, game.rng));
+    }
+
+    double record_ms = 0, submit_ms = 0;
+    size_t calls = 0, recorded_runs = 0, sorted_runs = 0;
+    for (int frame = 0; frame < RENDER_BENCH_FRAMES; frame++)
+    {
+        auto start = chrono::steady_clock::now();
+        clear_screen(COLOR_BLACK);
+        draw_game(game);
+        display_hub(game);
+        auto recorded = chrono::steady_clock::now();
+        calls = submit_render_list(game.frame);
+        auto submitted = chrono::steady_clock::now();
+        refresh_screen();
+
+        record_ms += chrono::duration<double, milli>(recorded - start).count();
+        submit_ms += chrono::duration<double, milli>(submitted - recorded).count();
+        recorded_runs = count_render_runs(game.frame, false);
+        sorted_runs = count_render_runs(game.frame, true);
+    }
+
+    write_line(to_string(total_entities(game.spawner)) + " entities: " + to_string(calls) + " splashkit draw calls per frame, in " + to_string(recorded_runs) + " runs sharing a bitmap as recorded and " + to_string(sorted_runs) + " sorted");
+    write_line("recording: " + to_string(record_ms / RENDER_BENCH_FRAMES) + " ms, sorting and drawing: " + to_string(submit_ms / RENDER_BENCH_FRAMES) + " ms per frame");
+    free_worker_pool(game.pool);
+    free_game(game);
+}
+
+/**
+ * A benchmark that can be run instead of the game with --bench NAME N.
+ * 
+ * @field   name        the name given on the command line
+ * @field   window      opens the window and loads the bitmaps first, for the ones that draw
+ * @field   run         runs it with the N from the command line
+ */
+struct benchmark_data
+{
+    const char *name;
+    bool window;
+    void (*run)(int count, const program_options &options);
+};
+
+const benchmark_data BENCHMARKS[] = {
+    // the entity grid with 1000, 10000, ... up to N entities
+    {"spatial", false, [](int count, const program_options &) {
+         for (int n = 1000; n <= count; n *= 10)
+         {
+             run_spatial_benchmark(n);
+         }
+     }},
+    {"bullet", false, [](int count, const program_options &) { run_projectile_benchmark(count); }},
+    {"particle", false, [](int count, const program_options &) { run_particle_benchmark(count); }},
+    {"gravity", false, [](int count, const program_options &) { run_gravity_benchmark(count); }},
+    {"swarm", false, [](int count, const program_options &) { run_swarm_benchmark(count); }},
+    // flocks of 10000, 100000, ... up to N foes
+    {"boids", false, [](int count, const program_options &options) {
+         for (int n = 10000; n <= count; n *= 10)
+         {
+             run_flock_benchmark(n, options.threads);
+         }
+     }},
+    {"zoom", false, [](int count, const program_options &) { run_impostor_benchmark(count); }},
+    {"env", false, [](int count, const program_options &options) {
+         load_spawn_table();
+         run_env_benchmark(count, options.threads, options.seed);
+     }},
+    {"render", true, [](int count, const program_options &options) { run_render_benchmark(count, options.seed); }},
+};
+
+/**
+ * Runs the benchmark named in the options.
+ * 
+ * @return  the exit code, 1 when there is no benchmark with that name
+ */
+int run_benchmark(const program_options &options)
+{
+    string names;
+    for (const benchmark_data &bench : BENCHMARKS)
+    {
+        names += string(" ") + bench.name;
+        if (options.bench != bench.name)
+            continue;
+
+        if (bench.window)
+        {
+            open_window("space wars", WINDOW_WIDTH, WINDOW_HEIGHT);
+            load_resources();
+        }
+        bench.run(options.bench_count, options);
+        return 0;
+    }
+
+    write_line("unknown benchmark " + options.bench + ", the benchmarks are:" + names);
+    return 1;
+}
+
+/**
+ * A part of the game checked against a simple but slow way of doing the same.
+ * 
+ * @field   name    what is checked
+ * @field   run     the check, false if it found a difference
+ */
+struct check_data
+{
+    const char *name;
+    bool (*run)();
+};
+
+const check_data CHECKS[] = {
+    {"spatial queries", check_spatial_queries},
+    {"spawn table", check_spawn_table},
+    {"timer wheel", check_timer_wheel},
+    {"render sort", check_render_sort},
+};
+
+/**
+ * Runs every check and writes how each went.
+ * 
+ * @return  the exit code, 1 when a check failed
+ */
+int run_checks()
+{
+    int result = 0;
+    for (const check_data &check : CHECKS)
+    {
+        bool passed = check.run();
+        write_line(string(check.name) + (passed ? ": ok" : ": FAILED"));
+        if (not passed)
+            result = 1;
+    }
+    return result;
+}
+
+/**
+ * @brief   procedure to display the welcome screen
+ *          with the rules and controls of game
+ * 
+ * @param choice    it decides what to display as per users choice
+ */
+void welcome_screen(int &choice)
+{
+    choice = 1;
+    dirty_tracker dirty = new_dirty_tracker();
+    still_screen shown = new_still_screen("");
+
+    while (not quit_requested())
+    {
+        process_events();
+
+        if (key_typed(BACKSPACE_KEY))
+            choice = 1;
+
+        if (key_typed(NUM_1_KEY))
+            choice = 2;
+
+        if (key_typed(SPACE_KEY))
+            break;
+
+        // the pages only change on a key, so most of the time this just waits
+        show_still_screen(dirty, shown, new_still_screen(choice == 1 ? "1" : "2"));
+    }
+}
+
+/**
+ * @brief   procedure to display the end screen
+ *          with the score of player
+ * 
+ * @param game      the main game variable used in various tasks
+ * @param choice    displays end screen as per players loss
+ */
+void end_screen(const game_data &game, int &choice)
+{
+    choice = game.game_over_by;
+    dirty_tracker dirty = new_dirty_tracker();
+    still_screen shown = new_still_screen("");
+
+    still_screen end = new_still_screen(choice == 2 ? "end_fuel" : "end_hit");
+    end.text = "SCORE - " + to_string(game.player.score);
+    end.font = "game_font";
+    end.size = 35;
+    end.x = 390;
+    end.y = 350;
+
+    while (not quit_requested())
+    {
+        process_events();
+
+        if (key_typed(SPACE_KEY))
+        {
+            choice = 1;
+            break;
+        }
+
+        if (key_typed(X_KEY))
+        {
+            choice = 0;
+            break;
+        }
+
+        // the score is drawn once with the bitmap, after that nothing changes
+        show_still_screen(dirty, shown, end);
+    }
+}
+
+/**
+ * Entry point.
+ * 
+ * Manages the initialisation of data, the event loop, and quitting.
+ */
+#ifndef SPACE_WARS_LIBRARY
+int main(int argc, char *argv[])
+{
+    program_options options = read_options(argc, argv);
+
+    if (options.check)
+        return run_checks();
+
+    if (not options.bench.empty())
+        return run_benchmark(options);
+
+    if (options.balance > 0)
+    {
+        load_spawn_table();
+        run_balance(options.balance, options.threads, options.seed);
+        return 0;
+    }
+
+    if (options.headless)
+        return run_headless(options);
+
+    open_window("space wars", WINDOW_WIDTH, WINDOW_HEIGHT);
+    load_resources();
+
+    starfield_data stars = new_starfield();
+    frame_pacer pacer = new_frame_pacer(TICKS_PER_SECOND, options.frame_stats);
+    worker_pool *pool = new_worker_pool(options.threads);
+
+    auto start = chrono::steady_clock::now();
+    int played = 0;
+    soak_data soak;
+
+    // every game gets the next seed, played only counts the autopilot's games for --sessions
+    int games = 0;
+
+    int choice = 1;
+    while (not quit_requested())
+    {
+
+        game_data game = new_game(false, options.seed + games++);
+        game.pool = pool;
+        if (options.swarm)
+            start_swarm(game);
+
+        // the autopilot does not need the rules
+        if (not options.bot)
+            welcome_screen(choice);
+
+        while (not quit_requested())
+        {
+            // checks and plays music if not playing
+            if (not music_playing())
+                play_music("bg");
+
+            // picks up changes to the spawn weights without restarting
+            reload_spawn_table_if_changed();
+
+            // the input is read as late as the frame allows, right before the update that uses it
+            wait_for_frame(pacer);
+
+            // Handle input to adjust player movement
+            process_events();
+            if (options.bot)
+                autopilot_input(game);
+            else
+            {
+                handle_input(game.player); // Perform movement and update the camera
+                handle_fire_input(game);
+            }
+
+            update_game(game);
+
+            // Redraw everything
+            clear_screen(COLOR_BLACK);
+
+            // the window looks through the game's own camera
+            set_camera_position(game.player.camera);
+
+            // draw the background, game and hud
+            draw_starfield(stars);
+            draw_game(game);
+            display_hub(game);
+            submit_render_list(game.frame);
+
+            if (game.player.game_over)
+                break;
+
+            // the pacer keeps the beat, so the screen is shown as soon as it is drawn
+            refresh_screen();
+            frame_presented(pacer);
+        }
+
+        stop_music();
+        free_game(game);
+
+        // the autopilot goes straight on to the next game
+        if (options.bot)
+        {
+            played++;
+            write_line(session_summary(game, played));
+
+            if (options.soak)
+                record_soak_sample(soak);
+
+            if (sessions_done(options, played, start))
+                break;
+            continue;
+        }
+
+        end_screen(game, choice);
+        if (choice == 0)
+            break;
+    }
+
+    free_starfield(stars);
+    free_worker_pool(pool);
+
+    if (not options.frame_stats.empty())
+        write_frame_stats(pacer);
+
+    if (options.soak and not soak_passed(soak))
+        return 1;
+    return 0;
+}
+#endif
+
 /*.-----------.| thank you |'-----------'*/
\ No newline at end of file